@@ -1,20 +1,47 @@
 #pragma once
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "TripleBuffer.h"
+#include "Telemetry.h"
+#include "GpuProfiler.h"
+#include "MemoryStats.h"
+
 //Forward declare the GLFWindow structure
 // avoid #includes where possible
 
 struct GLFWwindow;
+struct ImGuiFrameSnapshot;
+class HeadlessContext;
 
 class Application
 {
 public:
 	// Constructor, sets running to false
-	Application() : m_window(nullptr), m_windowHeight(0), m_windowWidth(0), m_running(false) {}
+	Application() : m_window(nullptr), m_windowWidth(0), m_windowHeight(0), m_running(false), m_renderSlot(0),
+		m_frameStartAllocations(0), m_lastFrameAllocations(0),
+		m_useRenderThread(false), m_renderThreadRunning(false), m_uiSnapshots(nullptr), m_telemetryEnabled(false),
+		m_headless(false), m_headlessContext(nullptr), m_captureKeyDown(false), m_frameLimit(0), m_presentedFrames(0), m_traceAfterFrames(0), m_loadMs(0.f) {}
 	virtual ~Application() {}
 
 	bool Create(const char* a_applicationName, unsigned int a_windowWidth, unsigned int a_windowHeight, bool a_fullscreen);
-	void Run(const char* a_applicationName, unsigned int a_windowWidth, unsigned int a_windowHeight, bool a_fullscreen);
+	// Returns false if the application couldn't be created
+	bool Run(const char* a_applicationName, unsigned int a_windowWidth, unsigned int a_windowHeight, bool a_fullscreen);
 	void Quit() { m_running = false; }
+	// Render on a dedicated thread that owns the GL context, set before calling Run
+	void SetRenderThread(bool a_enabled) { m_useRenderThread = a_enabled; }
+	// Write performance telemetry while running, set before calling Run
+	void EnableTelemetry(const TelemetryConfig& a_config) { m_telemetryConfig = a_config; m_telemetryEnabled = true; }
+	// Render offscreen with no window, the window size becomes the framebuffer size. Set before calling Run
+	void SetHeadless(bool a_enabled) { m_headless = a_enabled; }
+	// Stop after a_frames presented frames and print timing results, 0 runs until the window is closed
+	// With the render thread the main thread then waits for each frame to be taken, so it can't run ahead of what's drawn
+	void SetFrameLimit(unsigned int a_frames) { m_frameLimit = a_frames; }
+	unsigned int GetFrameLimit() const { return m_frameLimit; }
+	// Write a CPU trace after a_frames frames, 0 leaves it to F9
+	void SetTraceAfterFrames(unsigned int a_frames) { m_traceAfterFrames = a_frames; }
 
 protected:
 	//Pure virtual functions to be implemented by child classes
@@ -22,6 +49,9 @@ protected:
 	virtual void Update(float deltaTime) = 0;
 	virtual void Draw() = 0;
 	virtual void Destroy() = 0;
+	// Copy everything Draw needs into snapshot slot a_slot (0-2), called on the main thread after Update
+	// Draw must only read from the snapshot in m_renderSlot as it may be running on the render thread
+	virtual void CaptureFrame(unsigned int a_slot) = 0;
 	// Imgui windows
 	void showFrameData(bool a_bShowFrameData);
 	void ResizeWindow(bool a_bResizeWindow);
@@ -30,5 +60,50 @@ protected:
 	unsigned int m_windowHeight;
 
 	bool m_running;
+	// Snapshot slot the current Draw call should read from
+	unsigned int m_renderSlot;
+	// Heap allocation counts for the frame stats overlay
+	unsigned long long m_frameStartAllocations;
+	unsigned long long m_lastFrameAllocations;
+	unsigned long long m_tagAllocationStart[MemoryStats::Tag_Count] = {};
+	unsigned long long m_lastFrameTagAllocations[MemoryStats::Tag_Count] = {};
+	// Reused by the overlay each frame
+	std::vector<GpuProfiler::ScopeStats> m_gpuStats;
+
+private:
+	void StartRenderThread();
+	void StopRenderThread();
+	void RenderThreadLoop();
+	// Deep copy this frame's ImGui draw data into a snapshot slot
+	void CaptureUI(unsigned int a_slot);
+	// Window or headless context
+	bool OpenWindow(const char* a_applicationName, bool a_fullscreen);
+	// Polls window events, returns false once the window has been asked to close
+	bool PollWindow();
+	void InitImGuiPlatform();
+	void NewImGuiPlatformFrame(float a_deltaTime);
+	void ShutdownImGuiPlatform();
+	void MakeContextCurrent(bool a_current);
+	void PresentFrame();
+	void DestroyContext();
+	void PrintBenchmarkResults(unsigned long long a_frames, double a_seconds);
+
+	bool m_useRenderThread;
+	std::thread m_renderThread;
+	std::atomic<bool> m_renderThreadRunning;
+	// Main thread writes frames, the render thread reads the newest one
+	TripleBuffer m_frameHandoff;
+	ImGuiFrameSnapshot* m_uiSnapshots;
+
+	bool m_telemetryEnabled;
+	TelemetryConfig m_telemetryConfig;
 
+	bool m_headless;
+	HeadlessContext* m_headlessContext;
+	bool m_captureKeyDown;
+	unsigned int m_frameLimit;
+	// Frames that reached PresentFrame, on whichever thread draws
+	std::atomic<unsigned long long> m_presentedFrames;
+	unsigned int m_traceAfterFrames;
+	float m_loadMs;
 };
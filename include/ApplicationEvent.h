@@ -11,8 +11,11 @@ public:
 	WindowResizeEvent(uint32_t a_width, uint32_t a_height) :
 		m_width(a_width), m_height(a_height) {}
 
+	static constexpr EventTypes typeID = WindowResizeEventType;
 	static constexpr DescriptorType descriptor = "WindowResizeEvent";
 	virtual DescriptorType type() const { return descriptor; }
+	// Only the latest size matters so every resize shares one key
+	virtual unsigned int CoalesceKey() const { return 0; }
 	inline uint32_t GetWidth() { return m_width; }
 	inline uint32_t GetHeight() { return m_height; }
 
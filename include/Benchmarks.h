@@ -0,0 +1,11 @@
+#pragma once
+
+// Micro benchmarks for the engine's core systems, run from the Benchmarks menu and reported to the console
+class Benchmarks
+{
+public:
+	// Many producer threads hammering one EventChannel while this thread drains it
+	static void EventChannelThroughput(unsigned int a_eventsPerRun = 4000000);
+	// Runs the same parallel workloads on job systems with 1 up to all cores and reports the speedup
+	static void JobSystemScaling(unsigned int a_elementCount = 1 << 24);
+};
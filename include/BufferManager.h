@@ -0,0 +1,30 @@
+#pragma once
+#include "SlotMap.h"
+
+struct BufferTag;
+// Handle to a GL buffer owned by the BufferManager, resolve it with GetBufferID when binding
+typedef Handle<BufferTag> BufferHandle;
+
+class BufferManager
+{
+public:
+	// Manager Class will act as a Singleton object for easy access
+	static BufferManager* CreateInstance();
+	static BufferManager* GetInstance();
+	static void DestroyInstance();
+
+	// Generates a buffer name, the caller binds and fills it however it needs (glBufferData/glBufferStorage)
+	BufferHandle	CreateBuffer();
+	void			DestroyBuffer(BufferHandle a_buffer);
+	// GL buffer name for a handle, 0 for a null or destroyed handle
+	unsigned int	GetBufferID(BufferHandle a_buffer) const;
+	size_t			GetBufferCount() const { return m_buffers.Size(); }
+
+private:
+	static BufferManager* m_instance;
+
+	SlotMap<unsigned int, BufferTag> m_buffers;
+
+	BufferManager();
+	~BufferManager();
+};
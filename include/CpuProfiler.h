@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// CPU zone timing for Chrome/Perfetto traces (chrome://tracing or ui.perfetto.dev)
+// Every thread records finished zones into its own fixed size ring, so recording never locks or allocates
+// and a thread that records a lot only ever overwrites its own oldest zones. A thread's ring is handed back when it exits
+// and given to the next new thread, so short lived threads don't each keep one. The rings are copied out
+// and written as trace JSON at the end of a frame, either on request (F9 in Application) or after a set number of frames.
+// Define CPU_PROFILER_DISABLED to compile the macros away completely, otherwise SetEnabled(false) leaves a zone costing
+// one relaxed load.
+class CpuProfiler
+{
+public:
+	static CpuProfiler* CreateInstance();
+	static CpuProfiler* GetInstance() { return m_instance; }
+	static void DestroyInstance();
+
+	typedef long long Timestamp;
+	static Timestamp Now() { return std::chrono::steady_clock::now().time_since_epoch().count(); }
+
+	bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+	void SetEnabled(bool a_enabled) { m_enabled.store(a_enabled, std::memory_order_relaxed); }
+
+	// Name shown for the calling thread in the trace
+	void SetThreadName(const char* a_name);
+	// a_name must outlive the profiler, string literals and __FUNCTION__ are the intended use
+	void RecordZone(const char* a_name, Timestamp a_start, Timestamp a_end);
+
+	// Write a trace of everything still in the rings at the end of the current frame
+	void RequestCapture() { m_captureRequested.store(true); }
+	// Write a trace once a_frameCount more frames have finished, 0 cancels
+	void CaptureAfterFrames(unsigned int a_frameCount) { m_framesUntilCapture = a_frameCount; }
+	// Call once per frame from the main thread, writes any capture that's due
+	void EndFrame();
+
+	// Number of zones each thread keeps, older ones are overwritten
+	static const unsigned int ZonesPerThread = 1 << 14;
+
+private:
+	CpuProfiler();
+	~CpuProfiler();
+	static CpuProfiler* m_instance;
+	// Bumped for every instance so threads notice their cached ring belongs to an old profiler
+	static std::atomic<unsigned int> m_instanceCount;
+
+	typedef struct Zone
+	{
+		const char* name;
+		Timestamp start;
+		Timestamp end;
+	} Zone;
+
+	// Zones are written with relaxed atomics, which are plain stores on x86/ARM, so a capture reading
+	// a slot while its owner overwrites it gets a torn zone rather than undefined behaviour
+	typedef struct RingZone
+	{
+		std::atomic<const char*> name;
+		std::atomic<Timestamp> start;
+		std::atomic<Timestamp> end;
+	} RingZone;
+
+	// Only the owning thread writes, writeIndex is published after each zone so a reader can tell
+	// which entries it might have raced with and throw those away
+	typedef struct ThreadRing
+	{
+		RingZone zones[ZonesPerThread];
+		std::atomic<unsigned long long> writeIndex;
+		unsigned int threadID;
+		std::string name;
+	} ThreadRing;
+
+	ThreadRing* GetThreadRing();
+	// Called as a thread that recorded exits, its zones stay in the ring until another thread takes it over
+	void ReleaseThreadRing(ThreadRing* a_ring);
+	friend struct ThreadRingRelease;
+	void WriteTrace();
+
+	std::atomic<bool> m_enabled;
+	std::atomic<bool> m_captureRequested;
+	unsigned int m_framesUntilCapture;
+	unsigned int m_captureCount;
+	unsigned int m_instanceID;
+	Timestamp m_startTime;
+
+	// Only locked when a thread records its first zone and while writing a capture
+	std::mutex m_ringMutex;
+	std::vector<ThreadRing*> m_rings;
+	// Rings whose thread has exited, reused before a new one is made
+	std::vector<ThreadRing*> m_freeRings;
+};
+
+// Times the enclosing block on the calling thread
+class CpuProfileZone
+{
+public:
+	explicit CpuProfileZone(const char* a_name) : m_name(a_name), m_start(0)
+	{
+		CpuProfiler* profiler = CpuProfiler::GetInstance();
+		if (profiler && profiler->IsEnabled()) { m_start = CpuProfiler::Now(); }
+	}
+	~CpuProfileZone()
+	{
+		if (m_start == 0) { return; }
+		// The profiler could have been turned off mid zone, in which case it just doesn't get recorded
+		CpuProfiler* profiler = CpuProfiler::GetInstance();
+		if (profiler && profiler->IsEnabled()) { profiler->RecordZone(m_name, m_start, CpuProfiler::Now()); }
+	}
+	CpuProfileZone(const CpuProfileZone&) = delete;
+	CpuProfileZone& operator=(const CpuProfileZone&) = delete;
+
+private:
+	const char* m_name;
+	CpuProfiler::Timestamp m_start;
+};
+
+#ifndef CPU_PROFILER_DISABLED
+#define CPU_PROFILE_CONCAT_INNER(a, b) a##b
+#define CPU_PROFILE_CONCAT(a, b) CPU_PROFILE_CONCAT_INNER(a, b)
+#define CPU_PROFILE_SCOPE(name) CpuProfileZone CPU_PROFILE_CONCAT(cpuProfileZone_, __LINE__)(name)
+#define CPU_PROFILE_FUNCTION() CPU_PROFILE_SCOPE(__FUNCTION__)
+#else
+#define CPU_PROFILE_SCOPE(name) do {} while (0)
+#define CPU_PROFILE_FUNCTION() do {} while (0)
+#endif
@@ -1,16 +1,20 @@
 #pragma once
 
-#include <map>
-#include <list>
-#include <functional>
-#include <typeinfo>
-#include <typeindex>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <type_traits>
 
-#include "Observer.h"
 #include "Event.h"
+#include "EventChannel.h"
+#include "MemoryStats.h"
 
-// Create a typedefine for std::list<observer*> objects to improve code readability
-typedef std::list<Observer*> ObserverList;
+// Returned from Subscribe and passed back to Unsubscribe to remove a handler
+typedef struct SubscriptionHandle
+{
+	unsigned int eventType;
+	unsigned int id;		// 0 is never issued so a zeroed handle is always invalid
+} SubscriptionHandle;
 
 class Dispatcher
 {
@@ -20,6 +24,7 @@ public:
 	{
 		if (m_instance == nullptr)		// If we dont have an instance then create one and return it
 		{
+			MemoryTagScope memoryTag(MemoryStats::Events);
 			m_instance = new Dispatcher();
 		}
 		return m_instance;				// Otherwise just return it
@@ -33,86 +38,241 @@ public:
 		}
 	}
 #pragma region Subscription
-	// Subscription function to subscribe observers to an event, member function pointer implementation
-	template< typename T, typename ConcreteEvent>
-	void Subscribe(T* a_instance, void(T::* memberFunction)(ConcreteEvent*))
-	{
-		// Get a list of observers from the subscribers map
-		ObserverList* observers = m_subscribers[typeid(ConcreteEvent)];
-		// If observers is null there are no observers for this event yet
-		if (observers == nullptr)
-		{
-			// Create new list for event type and add this into the subscribers map
-			observers = new ObserverList();
-			m_subscribers[typeid(ConcreteEvent)] = observers;
-			//! Push a new member observer into the observers list from the subscribers map
-			observers->push_back(new MemberObserver<T, ConcreteEvent>(a_instance, memberFunction));
-		}
+	// Subscribe a member function to its event type, the function is a template argument so the call is bound at compile time
+	// e.g. dp->Subscribe<&RenderFramework::onWindowResize>(this);
+	template<auto MemberFunction, typename T>
+	SubscriptionHandle Subscribe(T* a_instance)
+	{
+		typedef typename MemberFunctionTraits<decltype(MemberFunction)>::EventType ConcreteEvent;
+		return AddHandler(ConcreteEvent::typeID, a_instance, &MemberThunk<T, ConcreteEvent, MemberFunction>);
 	}
 	// Subscribe method for global functions to become event subscribers
-	template<typename ConcreteEvent>
-	void Subscribe(void(*Function)(ConcreteEvent*))
+	// e.g. dp->Subscribe<&OnWindowResize>();
+	template<auto Function>
+	SubscriptionHandle Subscribe()
+	{
+		typedef typename GlobalFunctionTraits<decltype(Function)>::EventType ConcreteEvent;
+		return AddHandler(ConcreteEvent::typeID, nullptr, &GlobalThunk<ConcreteEvent, Function>);
+	}
+	// Remove a handler, safe to call from inside a handler while its event is being published
+	void Unsubscribe(SubscriptionHandle& a_handle)
 	{
-		// Get a list of observers from the subscribers map
-		ObserverList* observers = m_subscribers[typeid(ConcreteEvent)];
-		if (observers == nullptr)
+		if (a_handle.id == 0 || a_handle.eventType >= EventTypes_Count) { return; }
+		std::vector<EventHandler>& handlers = m_handlers[a_handle.eventType];
+		for (size_t i = 0; i < handlers.size(); ++i)
 		{
-			//! create new list for event type and add this into the subscribers map
-			observers = new ObserverList();
-			m_subscribers[typeid(ConcreteEvent)] = observers;
+			if (handlers[i].id == a_handle.id)
+			{
+				// While publishing just clear the thunk, the list is compacted once publishing finishes
+				if (m_publishDepth > 0) { handlers[i].thunk = nullptr; m_pendingRemoval = true; }
+				else { handlers.erase(handlers.begin() + i); }
+				break;
+			}
 		}
-		// Push a new member observer into the observers list from the subscribers map
-		observers->push_back(new GlobalObserver<ConcreteEvent>(Function));
+		a_handle.id = 0;
 	}
 #pragma endregion Subscription
 
 #pragma region Publishing
 	// Function to publish an event and notify any subscribers...
-	// It will find the event type in the dictionary and then iterate through the 
-	// list of observers and call them to handle the event. If one of the observers marks 
-	// the event as handled then no other observers in the list will receive the event
+	// Events are passed by value/reference so publishing never allocates. The handler table for the event type is
+	// indexed directly and each handler called in subscription order. If one of the handlers marks
+	// the event as handled then no other handlers in the list will receive the event
 	template <typename ConcreteEvent>
-	void Publish(ConcreteEvent* e, bool cleanup = false)
+	void Publish(ConcreteEvent& e)
 	{
-		// Get the list of observers from the map
-		ObserverList* observers = m_subscribers[typeid(ConcreteEvent)];
-		if (observers == nullptr) { return; }
-		//! for each observer notify them that the event has occured
-		for (auto& handler : *observers)
+		static_assert(std::is_base_of<Event, ConcreteEvent>::value, "Published types must derive from Event");
+		std::vector<EventHandler>& handlers = m_handlers[ConcreteEvent::typeID];
+		++m_publishDepth;
+		// Index rather than iterate as a handler may subscribe more handlers and reallocate the array
+		for (size_t i = 0; i < handlers.size(); ++i)
 		{
-			handler->exec(e);
+			if (handlers[i].thunk == nullptr) { continue; }
+			handlers[i].thunk(handlers[i].instance, &e);
 			// If an event has been handled by a subscriber then we do not need to keep notifying other subscribers
-			if (static_cast<Event*>(e)->Ishandled())
+			if (static_cast<Event&>(e).Ishandled())
 			{
 				break;
 			}
 		}
-		// as we could pass through "new ConcreteEvent(" we should call delete if needed
-		if (cleanup) { delete e; }
+		if (--m_publishDepth == 0 && m_pendingRemoval) { CompactHandlers(); }
+	}
+	template <typename ConcreteEvent>
+	void Publish(ConcreteEvent&& e)
+	{
+		Publish(static_cast<ConcreteEvent&>(e));
 	}
+	// True if anything is listening for this event type, lets publishers skip building events nobody wants
+	template <typename ConcreteEvent>
+	bool HasSubscribers() const { return !m_handlers[ConcreteEvent::typeID].empty(); }
 #pragma endregion Publishing
 
-protected:
-	// Keep the constructors protected and use this dispatcher class as a singleton object
-	Dispatcher() {};
-	~Dispatcher()
+#pragma region Queueing
+	// Queue an event to be published when the queue is next flushed (once per frame from Application::Run)
+	// The event is copied into a fixed per-frame buffer, if a queued event of the same type and coalesce key
+	// is already waiting it is overwritten in place so a storm of resizes only costs one publish
+	template <typename ConcreteEvent>
+	void Enqueue(const ConcreteEvent& e)
 	{
-		// Better clean up the subscriber map
-		// We need to go through our subscriber dictionary list it contains and delete each item 
-		for (auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it)
+		static_assert(std::is_base_of<Event, ConcreteEvent>::value, "Queued types must derive from Event");
+		EventQueue& queue = m_queues[m_writeQueue];
+		unsigned int key = e.CoalesceKey();
+		if (key != Event::NotCoalesced)
 		{
-			ObserverList* obs = it->second;
-			for (auto o = obs->begin(); o != obs->end(); ++o)
+			for (QueuedEvent& queued : queue.events)
 			{
-				delete (*o);
-				(*o) = nullptr;
+				if (queued.eventType == ConcreteEvent::typeID && queued.key == key)
+				{
+					// Same type so same size and alignment, reuse the slot
+					ConcreteEvent* old = static_cast<ConcreteEvent*>(queued.event);
+					old->~ConcreteEvent();
+					queued.event = new (old) ConcreteEvent(e);
+					++m_coalescedCount;
+					return;
+				}
 			}
-			delete obs;
 		}
+		size_t offset = (queue.used + alignof(ConcreteEvent) - 1) & ~(alignof(ConcreteEvent) - 1);
+		if (offset + sizeof(ConcreteEvent) > QueueCapacity)
+		{
+			// Out of room this frame, fall back to publishing straight away rather than dropping it
+			ConcreteEvent copy(e);
+			Publish(copy);
+			return;
+		}
+		Event* queuedEvent = new (queue.storage + offset) ConcreteEvent(e);
+		queue.used = offset + sizeof(ConcreteEvent);
+		MemoryTagScope memoryTag(MemoryStats::Events);
+		queue.events.push_back(QueuedEvent{ &PublishQueued<ConcreteEvent>, queuedEvent, ConcreteEvent::typeID, key });
+	}
+	// Publish everything posted from worker threads, then everything queued since the last flush in the order it was queued
+	// Events queued by handlers during the flush go into the other buffer and are delivered next flush
+	void FlushQueue();
+	// Thread-safe publish for worker threads. The event goes into a lock-free ring and is published to subscribers
+	// on the main thread at the next FlushQueue. Waits (yielding) if the ring is full so nothing is dropped
+	template <typename ConcreteEvent>
+	void PostFromThread(const ConcreteEvent& e)
+	{
+		m_channel.Post(e, &DeliverFromChannel<ConcreteEvent>);
+	}
+	// As above but gives up and returns false when the ring is full
+	template <typename ConcreteEvent>
+	bool TryPostFromThread(const ConcreteEvent& e)
+	{
+		return m_channel.TryPost(e, &DeliverFromChannel<ConcreteEvent>);
+	}
+	EventChannelStats GetChannelStats() const { return m_channel.GetStats(); }
+	// Number of queued events that were merged into an earlier one since startup
+	unsigned long long GetCoalescedCount() const { return m_coalescedCount; }
+#pragma endregion Queueing
+
+protected:
+	// Keep the constructors protected and use this dispatcher class as a singleton object
+	Dispatcher() : m_nextHandlerID(1), m_publishDepth(0), m_pendingRemoval(false), m_channel(4096), m_writeQueue(0), m_coalescedCount(0)
+	{
+		// Reserve up front so queueing doesn't allocate during the frame
+		m_queues[0].events.reserve(64);
+		m_queues[1].events.reserve(64);
 	};
+	~Dispatcher() { ClearQueue(m_queues[0]); ClearQueue(m_queues[1]); };
 
 private:
+	// A handler is an instance pointer plus a thunk that casts the event and calls the bound function
+	typedef void (*HandlerThunk)(void* a_instance, Event* e);
+	typedef struct EventHandler
+	{
+		HandlerThunk thunk;
+		void* instance;
+		unsigned int id;
+	} EventHandler;
+
+	template<typename T, typename ConcreteEvent, void (T::* MemberFunction)(ConcreteEvent*)>
+	static void MemberThunk(void* a_instance, Event* e)
+	{
+		(static_cast<T*>(a_instance)->*MemberFunction)(static_cast<ConcreteEvent*>(e));
+	}
+	template<typename ConcreteEvent, void (*Function)(ConcreteEvent*)>
+	static void GlobalThunk(void*, Event* e)
+	{
+		(*Function)(static_cast<ConcreteEvent*>(e));
+	}
+
+	// Deduce the event type from the handler's signature
+	template<typename F> struct MemberFunctionTraits;
+	template<typename T, typename ConcreteEvent> struct MemberFunctionTraits<void (T::*)(ConcreteEvent*)> { typedef ConcreteEvent EventType; };
+	template<typename F> struct GlobalFunctionTraits;
+	template<typename ConcreteEvent> struct GlobalFunctionTraits<void (*)(ConcreteEvent*)> { typedef ConcreteEvent EventType; };
+
+	SubscriptionHandle AddHandler(unsigned int a_eventType, void* a_instance, HandlerThunk a_thunk)
+	{
+		EventHandler handler = { a_thunk, a_instance, m_nextHandlerID++ };
+		MemoryTagScope memoryTag(MemoryStats::Events);
+		m_handlers[a_eventType].push_back(handler);
+		return SubscriptionHandle{ a_eventType, handler.id };
+	}
+	void CompactHandlers()
+	{
+		for (unsigned int type = 0; type < EventTypes_Count; ++type)
+		{
+			std::vector<EventHandler>& handlers = m_handlers[type];
+			for (size_t i = 0; i < handlers.size();)
+			{
+				if (handlers[i].thunk == nullptr) { handlers.erase(handlers.begin() + i); }
+				else { ++i; }
+			}
+		}
+		m_pendingRemoval = false;
+	}
+
+	// A queued event lives in the owning queue's byte buffer
+	typedef void (*QueuedPublish)(Dispatcher* a_dispatcher, Event* e);
+	typedef struct QueuedEvent
+	{
+		QueuedPublish publish;
+		Event* event;
+		unsigned int eventType;
+		unsigned int key;
+	} QueuedEvent;
+
+	static constexpr size_t QueueCapacity = 16 * 1024;
+	typedef struct EventQueue
+	{
+		alignas(std::max_align_t) unsigned char storage[QueueCapacity];
+		size_t used = 0;
+		std::vector<QueuedEvent> events;
+	} EventQueue;
+
+	template<typename ConcreteEvent>
+	static void PublishQueued(Dispatcher* a_dispatcher, Event* e)
+	{
+		a_dispatcher->Publish(*static_cast<ConcreteEvent*>(e));
+	}
+	template<typename ConcreteEvent>
+	static void DeliverFromChannel(void* a_dispatcher, Event* e)
+	{
+		static_cast<Dispatcher*>(a_dispatcher)->Publish(*static_cast<ConcreteEvent*>(e));
+	}
+	// Calls the destructors of everything still in the queue and resets it
+	void ClearQueue(EventQueue& a_queue)
+	{
+		for (QueuedEvent& queued : a_queue.events)
+		{
+			queued.event->~Event();
+		}
+		a_queue.events.clear();
+		a_queue.used = 0;
+	}
+
 	static Dispatcher* m_instance;
-	// A hash map of observers uses typeid of Event class as an index into the map.
-	std::map<std::type_index, ObserverList*> m_subscribers;
+	// One contiguous handler array per event type, indexed by the event's typeID
+	std::vector<EventHandler> m_handlers[EventTypes_Count];
+	unsigned int m_nextHandlerID;
+	unsigned int m_publishDepth;
+	bool m_pendingRemoval;
+	// Events posted from other threads, drained on the main thread by FlushQueue
+	EventChannel m_channel;
+	// Double buffered deferred queue, m_writeQueue receives Enqueue calls while the other is flushed
+	EventQueue m_queues[2];
+	unsigned int m_writeQueue;
+	unsigned long long m_coalescedCount;
 };
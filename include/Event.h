@@ -1,4 +1,17 @@
 #pragma once
+//! Event type IDs.
+/*!
+	Every concrete event class declares one of these as its static typeID. The IDs are dense and known at
+	compile time so the dispatcher can index its handler tables directly, no RTTI or map lookups required.
+	Add new event types above EventTypes_Count.
+*/
+enum EventTypes : unsigned int
+{
+	WindowResizeEventType = 0,
+
+	EventTypes_Count
+};
+
 //!. Event Class.
 /*!
 	 An abstract base class for concrete event classes to inherit from.
@@ -16,11 +29,18 @@ public:
 	virtual ~Event() {};
 	//! using the 'using' command to create an alias for const char*
 	using DescriptorType = const char*;
+	//! Key returned by events that should never be merged in the deferred queue
+	static constexpr unsigned int NotCoalesced = 0xFFFFFFFFu;
 	// Returns the descriptor type of the event.
 	/*! Abstract function to be implemented in derived classes
 		Return DescriptorType returns the type of Event as a const char*
 	*/
 	virtual DescriptorType type() const = 0;
+	// Returns the coalescing key for the deferred queue.
+	/*! Queued events of the same type with the same key replace each other so only the latest survives the frame.
+		Defaults to NotCoalesced so every queued event is delivered.
+	*/
+	virtual unsigned int CoalesceKey() const { return NotCoalesced; }
 	/*!
 	*. Function used to set if an event has been handled. Events that are handled do not report
 	* to any subsequent observers
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include "Event.h"
+
+// Back-pressure statistics for an EventChannel, read on the consumer thread
+typedef struct EventChannelStats
+{
+	unsigned long long posted;		// Events successfully written by producers
+	unsigned long long drained;		// Events delivered by the consumer
+	unsigned long long rejected;	// TryPost calls that found the ring full
+	unsigned long long stalls;		// Times a blocking Post had to wait for the consumer
+	unsigned long long peakDepth;	// Most events seen waiting at the start of a drain
+} EventChannelStats;
+
+// Bounded lock-free multi-producer single-consumer ring of events
+// Any thread can post, only one thread (the main thread for the Dispatcher) may drain. Each slot carries a sequence
+// number so producers claim slots with a single CAS and the consumer never needs a lock. Events are copied into
+// fixed size slots so posting never allocates
+class EventChannel
+{
+public:
+	// Called on the consumer thread for every drained event
+	typedef void (*DeliverFunction)(void* a_context, Event* e);
+	static constexpr size_t SlotPayloadSize = 48;
+
+	// Capacity is rounded up to a power of two
+	explicit EventChannel(size_t a_capacity = 1024);
+	~EventChannel();
+
+	EventChannel(const EventChannel&) = delete;
+	EventChannel& operator=(const EventChannel&) = delete;
+
+	// Try to post without waiting, returns false if the ring is full
+	template<typename ConcreteEvent>
+	bool TryPost(const ConcreteEvent& e, DeliverFunction a_deliver)
+	{
+		Slot* slot = ClaimSlot();
+		if (slot == nullptr)
+		{
+			m_rejected.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		Write(slot, e, a_deliver);
+		return true;
+	}
+	// Post and wait (yielding) while the ring is full
+	template<typename ConcreteEvent>
+	void Post(const ConcreteEvent& e, DeliverFunction a_deliver)
+	{
+		Slot* slot = ClaimSlot();
+		if (slot == nullptr)
+		{
+			m_stalls.fetch_add(1, std::memory_order_relaxed);
+			do
+			{
+				Backoff();
+				slot = ClaimSlot();
+			} while (slot == nullptr);
+		}
+		Write(slot, e, a_deliver);
+	}
+
+	// Consumer only - deliver up to a_maxEvents waiting events, returns the number delivered
+	size_t Drain(void* a_context, size_t a_maxEvents = (size_t)-1);
+	// Consumer only - approximate as producers may be mid-post
+	size_t GetDepth() const;
+	size_t GetCapacity() const { return m_mask + 1; }
+	EventChannelStats GetStats() const;
+
+private:
+	// One cache line per slot so neighbouring producers don't false share
+	typedef struct alignas(64) Slot
+	{
+		std::atomic<size_t> sequence;
+		size_t claimed;
+		DeliverFunction deliver;
+		Event* event;
+		alignas(std::max_align_t) unsigned char payload[SlotPayloadSize];
+	} Slot;
+
+	template<typename ConcreteEvent>
+	static void Write(Slot* a_slot, const ConcreteEvent& e, DeliverFunction a_deliver)
+	{
+		static_assert(std::is_base_of<Event, ConcreteEvent>::value, "Posted types must derive from Event");
+		static_assert(sizeof(ConcreteEvent) <= SlotPayloadSize, "Event is too big for an EventChannel slot");
+		static_assert(alignof(ConcreteEvent) <= alignof(std::max_align_t), "Event is over-aligned for an EventChannel slot");
+		a_slot->event = new (a_slot->payload) ConcreteEvent(e);
+		a_slot->deliver = a_deliver;
+		// Publishing the sequence hands the slot to the consumer
+		a_slot->sequence.store(a_slot->claimed + 1, std::memory_order_release);
+	}
+	// Returns a slot owned by this producer, or nullptr if the ring is full
+	Slot* ClaimSlot();
+	static void Backoff();
+
+	Slot* m_slots;
+	size_t m_mask;
+	// Producers and the consumer hammer different counters, keep them on separate lines
+	alignas(64) std::atomic<size_t> m_enqueuePos;
+	alignas(64) size_t m_dequeuePos;
+	unsigned long long m_peakDepth;
+	alignas(64) std::atomic<unsigned long long> m_rejected;
+	std::atomic<unsigned long long> m_stalls;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Bump allocator over one block of memory, everything is freed at once by Reset
+// If a frame needs more than the block holds the extra comes from malloc and the block grows to fit on the next Reset,
+// so after a frame or two a steady workload never touches the heap. Running out of memory throws std::bad_alloc
+class LinearArena
+{
+public:
+	explicit LinearArena(size_t a_capacity);
+	~LinearArena();
+	LinearArena(const LinearArena&) = delete;
+	LinearArena& operator=(const LinearArena&) = delete;
+
+	void* Allocate(size_t a_size, size_t a_alignment = alignof(std::max_align_t));
+	void Reset();
+
+	size_t GetUsed() const { return m_used; }
+	// Bytes allocated in the frame before the last Reset
+	size_t GetLastFrameUsed() const { return m_lastFrameUsed; }
+	size_t GetCapacity() const { return m_capacity; }
+	// Most bytes asked for in a single frame, including overflow
+	size_t GetPeak() const { return m_peak; }
+	unsigned long long GetOverflowCount() const { return m_overflowCount; }
+
+private:
+	unsigned char* m_memory;
+	size_t m_capacity;
+	size_t m_offset;
+	size_t m_used;
+	size_t m_lastFrameUsed;
+	size_t m_peak;
+	unsigned long long m_overflowCount;
+	// Heap blocks for allocations that didn't fit, chained through a header at the front of each so keeping track of
+	// them never allocates
+	struct OverflowBlock { OverflowBlock* next; };
+	OverflowBlock* m_overflow;
+};
+
+// Frame scoped scratch memory for transient render data
+// Each job system thread gets its own arena so jobs can allocate without locking, any other thread shares a locked one.
+// Application::Run resets every arena at the top of the frame so nothing allocated here may be kept past the frame
+class FrameAllocator
+{
+public:
+	static FrameAllocator* GetInstance() { return m_instance; }
+	static FrameAllocator* CreateInstance(unsigned int a_threadCount, size_t a_bytesPerThread = 256 * 1024)
+	{
+		if (m_instance == nullptr)
+		{
+			m_instance = new FrameAllocator(a_threadCount, a_bytesPerThread);
+		}
+		return m_instance;
+	}
+	static void DestroyInstance()
+	{
+		if (m_instance)
+		{
+			delete m_instance;
+			m_instance = nullptr;
+		}
+	}
+
+	// Allocate from the calling thread's arena
+	void* Allocate(size_t a_size, size_t a_alignment = alignof(std::max_align_t));
+	// Allocate an uninitialised array of a_count T
+	template<typename T>
+	T* AllocateArray(size_t a_count) { return static_cast<T*>(Allocate(sizeof(T) * a_count, alignof(T))); }
+	// Free everything allocated this frame, only call when no jobs are running
+	void Reset();
+
+	// Totals across all arenas
+	size_t GetLastFrameUsed() const;
+	size_t GetCapacity() const;
+	unsigned long long GetOverflowCount() const;
+
+protected:
+	FrameAllocator(unsigned int a_threadCount, size_t a_bytesPerThread);
+	~FrameAllocator();
+
+private:
+	static FrameAllocator* m_instance;
+	// One per job system thread
+	std::vector<LinearArena*> m_threadArenas;
+	// For threads outside the job system
+	LinearArena m_sharedArena;
+	std::mutex m_sharedMutex;
+};
+
+// STL allocator adaptor over the frame allocator, deallocate does nothing as memory goes back on Reset
+// e.g. FrameVector<unsigned int> indices; indices.reserve(meshCount);
+template<typename T>
+class FrameStdAllocator
+{
+public:
+	typedef T value_type;
+	FrameStdAllocator() = default;
+	template<typename U> FrameStdAllocator(const FrameStdAllocator<U>&) {}
+
+	T* allocate(size_t a_count) { return FrameAllocator::GetInstance()->AllocateArray<T>(a_count); }
+	void deallocate(T*, size_t) {}
+
+	template<typename U> bool operator==(const FrameStdAllocator<U>&) const { return true; }
+	template<typename U> bool operator!=(const FrameStdAllocator<U>&) const { return false; }
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameStdAllocator<T>>;
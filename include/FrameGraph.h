@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <vector>
+
+class JobSystem;
+
+// Per-frame task graph
+// Subsystems add tasks once at start up along with the resources each one reads and writes. Compile works out the
+// ordering from those (a task waits for earlier tasks that write what it touches, or read what it writes) and Execute
+// runs the whole graph every frame on the job system. Tasks flagged as main thread (input, ImGui, anything touching
+// the GL context) only ever run on the thread that calls Execute
+class FrameGraph
+{
+public:
+	// Resources are just IDs, the owner of the graph decides what they mean
+	typedef unsigned int Resource;
+	typedef std::function<void()> TaskFunction;
+
+	FrameGraph() : m_compiled(false), m_jobs(nullptr), m_remaining(0) {}
+	FrameGraph(const FrameGraph&) = delete;
+	FrameGraph& operator=(const FrameGraph&) = delete;
+
+	// Tasks must be added in the order they would run on a single thread, returns the task's index
+	unsigned int AddTask(const char* a_name, TaskFunction a_function,
+		std::initializer_list<Resource> a_reads, std::initializer_list<Resource> a_writes, bool a_mainThread = false);
+	// Build the dependency edges, called automatically by Execute if tasks have changed
+	void Compile();
+	// Run every task once and return when they've all finished, the calling thread runs main thread tasks and helps
+	// with the rest. Without a job system the tasks just run in order on this thread
+	void Execute(JobSystem* a_jobs);
+	void Clear();
+
+	unsigned int GetTaskCount() const { return (unsigned int)m_tasks.size(); }
+	const char* GetTaskName(unsigned int a_index) const { return m_tasks[a_index].name; }
+
+private:
+	typedef struct Task
+	{
+		const char* name;
+		TaskFunction function;
+		std::vector<Resource> reads;
+		std::vector<Resource> writes;
+		bool mainThread;
+		std::vector<unsigned int> successors;
+		unsigned int predecessorCount;
+	} Task;
+
+	// Queue a task whose dependencies have all finished
+	void Launch(unsigned int a_index);
+	// Run a task then launch any successors it was holding up
+	void RunTask(unsigned int a_index);
+
+	std::vector<Task> m_tasks;
+	bool m_compiled;
+	JobSystem* m_jobs;
+
+	// Per-frame state
+	std::vector<std::atomic<unsigned int>> m_pending;
+	std::atomic<unsigned int> m_remaining;
+	std::mutex m_mainThreadMutex;
+	std::vector<unsigned int> m_mainThreadReady;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+// Rolling window of frame times with percentiles, max and hitch counts kept up to date as samples come in
+// A histogram of the window is adjusted on every add/evict so percentiles are a walk over fixed buckets rather than a sort,
+// and the max comes from a monotonic queue so evicting the slowest frame doesn't mean rescanning the window.
+class FrameTimeSeries
+{
+public:
+	static const unsigned int Capacity = 1024;
+	// 0.1ms buckets up to 100ms, the last bucket takes everything slower
+	static const unsigned int BucketCount = 1000;
+	static constexpr float BucketWidthMs = 0.1f;
+
+	FrameTimeSeries();
+
+	void AddSample(float a_ms);
+	void Clear();
+
+	// a_percentile in 0-100. Reported as the top of the bucket it lands in (capped at the max) so it never under reports
+	float GetPercentile(float a_percentile) const;
+	float GetMax() const;
+	float GetAverage() const;
+	float GetLatest() const;
+	unsigned int GetCount() const { return m_count; }
+
+	// Frames over the threshold in the window, and since the series was started
+	void SetHitchThreshold(float a_ms);
+	float GetHitchThreshold() const { return m_hitchThresholdMs; }
+	unsigned int GetHitchCount() const { return m_windowHitches; }
+	unsigned long long GetTotalHitches() const { return m_totalHitches; }
+
+	// Window oldest first, for plotting
+	void CopySamples(std::vector<float>& a_samples) const;
+	// Histogram of the window merged down to a_binWidthMs wide bins covering 0 to a_maxMs
+	void CopyHistogram(std::vector<float>& a_bins, float a_binWidthMs, float a_maxMs) const;
+
+private:
+	static unsigned int BucketFor(float a_ms);
+
+	float m_samples[Capacity];
+	unsigned int m_histogram[BucketCount];
+	// Sequence numbers of samples that could still become the max, values decreasing from the front
+	unsigned long long m_maxQueue[Capacity];
+	unsigned int m_maxFront;
+	unsigned int m_maxSize;
+	unsigned long long m_sequence;	// Samples ever added, the newest is m_sequence - 1
+	unsigned int m_count;
+	double m_sum;
+	float m_hitchThresholdMs;
+	unsigned int m_windowHitches;
+	unsigned long long m_totalHitches;
+};
+
+// CPU and GPU frame time series for the overlay and anything else that wants tail frame times
+// The main thread records CPU frames, the GPU profiler records GPU frames from whichever thread resolves them.
+class FrameStats
+{
+public:
+	static FrameStats* CreateInstance();
+	static FrameStats* GetInstance() { return m_instance; }
+	static void DestroyInstance();
+
+	enum Series
+	{
+		CpuFrame,
+		GpuFrame,
+		Series_Count
+	};
+
+	typedef struct Summary
+	{
+		float p50;
+		float p95;
+		float p99;
+		float max;
+		float average;
+		float latest;
+		unsigned int count;
+		unsigned int hitches;			// In the current window
+		unsigned long long totalHitches;
+	} Summary;
+
+	void RecordCpuFrame(float a_ms) { Record(CpuFrame, a_ms); }
+	void RecordGpuFrame(float a_ms) { Record(GpuFrame, a_ms); }
+
+	Summary GetSummary(Series a_series) const;
+	float GetPercentile(Series a_series, float a_percentile) const;
+	void CopySamples(Series a_series, std::vector<float>& a_samples) const;
+	void CopyHistogram(Series a_series, std::vector<float>& a_bins, float a_binWidthMs, float a_maxMs) const;
+
+	// Frame time budget, anything over HitchFactor times this counts as a hitch
+	void SetBudget(float a_ms);
+	float GetBudget() const { return m_budgetMs; }
+	static constexpr float HitchFactor = 2.f;
+
+private:
+	FrameStats();
+	~FrameStats() {}
+	static FrameStats* m_instance;
+
+	void Record(Series a_series, float a_ms);
+
+	mutable std::mutex m_mutex;
+	FrameTimeSeries m_series[Series_Count];
+	float m_budgetMs;
+};
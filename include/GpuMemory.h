@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Registry of the GPU memory the framework allocates
+// Every buffer, texture and renderbuffer allocation is recorded next to the GL call that makes it (glBufferData,
+// glTexImage2D, glTexStorage*, glRenderbufferStorage) and released next to the delete, so the totals are what we asked the
+// driver for. Textures count their whole mip chain and every layer/face. Driver padding, the default framebuffer and ImGui's own GL objects aren't seen.
+// Recording happens on the GL thread, everything can be read from any thread.
+class GpuMemory
+{
+public:
+	enum Category
+	{
+		VertexBuffers,
+		IndexBuffers,
+		Textures,
+		TextureArrays,
+		Cubemaps,
+		RenderTargets,
+		Category_Count
+	};
+
+	typedef struct Allocation
+	{
+		unsigned int name;		// GL buffer, texture or renderbuffer name
+		Category category;
+		unsigned int format;	// GL internal format, 0 for buffers
+		size_t bytes;
+		std::string owner;		// File or subsystem the memory belongs to
+	} Allocation;
+
+	// Buffers are commonly re-specified with glBufferData, recording one again replaces its previous size
+	static void RecordBuffer(unsigned int a_buffer, Category a_category, size_t a_bytes, const char* a_owner);
+	static void ReleaseBuffer(unsigned int a_buffer);
+	static void RecordTexture(unsigned int a_texture, Category a_category, unsigned int a_format, unsigned int a_width, unsigned int a_height,
+		unsigned int a_layers, unsigned int a_mipLevels, const char* a_owner);
+	static void ReleaseTexture(unsigned int a_texture);
+	static void RecordRenderbuffer(unsigned int a_renderbuffer, unsigned int a_format, unsigned int a_width, unsigned int a_height, const char* a_owner);
+	static void ReleaseRenderbuffer(unsigned int a_renderbuffer);
+
+	static size_t GetTotalBytes();
+	static size_t GetPeakBytes();
+	static void GetCategoryBytes(size_t (&a_bytes)[Category_Count]);
+	// Copy of every live allocation, largest first
+	static void CopyAllocations(std::vector<Allocation>& a_allocations);
+
+	// Warn once each time the total goes over a_bytes, 0 turns the budget off
+	static void SetBudget(size_t a_bytes);
+	static size_t GetBudget();
+	static bool IsOverBudget();
+
+	static const char* GetCategoryName(Category a_category);
+	static const char* GetFormatName(unsigned int a_format);
+	// Size of a texture and its mip chain, a_layers is 6 for a cubemap
+	static size_t TextureBytes(unsigned int a_format, unsigned int a_width, unsigned int a_height, unsigned int a_layers, unsigned int a_mipLevels);
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// GPU timing from GL_TIMESTAMP queries
+// Scopes nest (timestamps rather than GL_TIME_ELAPSED, which can't be nested) and are identified by name under their parent.
+// Queries go into a ring of frames, results are read back FrameLatency frames later once they're available
+// so the CPU never waits on the GPU. A frame whose results still aren't ready by then is dropped rather than stalling.
+// Everything except GetStats and GetLastFrameTime must be called on the thread that owns the GL context.
+class GpuProfiler
+{
+public:
+	static GpuProfiler* CreateInstance();
+	static GpuProfiler* GetInstance();
+	static void DestroyInstance();
+
+	// Opens the root "Frame" scope, call before any drawing
+	void BeginFrame();
+	// Closes the root scope, call after the last draw and before swapping buffers
+	void EndFrame();
+	// a_name must outlive the profiler, string literals are the intended use
+	void BeginScope(const char* a_name);
+	void EndScope();
+
+	typedef struct ScopeStats
+	{
+		const char* name;
+		unsigned int depth;
+		float lastMs;
+		float averageMs;	// Over the last HistoryLength resolved frames
+		float maxMs;		// Over the same window
+	} ScopeStats;
+	// Latest results in tree order (parents before their children), safe to call from any thread
+	void GetStats(std::vector<ScopeStats>& a_stats) const;
+	// GPU time of the last resolved frame in ms, safe to call from any thread
+	float GetLastFrameTime() const;
+	unsigned long long GetDroppedFrames() const { return m_droppedFrames; }
+
+	static const unsigned int FrameLatency = 4;
+	static const unsigned int MaxScopesPerFrame = 64;
+	static const unsigned int MaxScopeDepth = 16;
+	static const unsigned int HistoryLength = 64;
+
+private:
+	GpuProfiler();
+	~GpuProfiler();
+	static GpuProfiler* m_instance;
+
+	typedef struct Scope
+	{
+		const char* name;
+		unsigned int parent;
+		unsigned int depth;
+		float history[HistoryLength];
+		unsigned int historyHead;
+		unsigned int historyCount;
+		float lastMs;
+		float averageMs;
+		float maxMs;
+	} Scope;
+
+	// One timed scope within a frame, the query pair is begin/end timestamps
+	typedef struct ScopeRecord
+	{
+		unsigned int scope;
+		unsigned int beginQuery;
+		unsigned int endQuery;
+	} ScopeRecord;
+
+	typedef struct FrameQueries
+	{
+		unsigned int queries[MaxScopesPerFrame * 2];
+		ScopeRecord records[MaxScopesPerFrame];
+		unsigned int recordCount;
+		bool pending;
+	} FrameQueries;
+
+	unsigned int FindScope(const char* a_name, unsigned int a_parent);
+	void ResolveFrame(FrameQueries& a_frame);
+	void PublishStats();
+	void AppendChildren(unsigned int a_parent, std::vector<ScopeStats>& a_stats) const;
+
+	static const unsigned int NoScope = 0xFFFFFFFFu;
+
+	bool m_initialised;
+	FrameQueries m_frames[FrameLatency];
+	unsigned int m_frameIndex;
+	FrameQueries* m_currentFrame;
+	// Open records for the current frame, NoScope marks a scope that didn't fit in the frame's queries
+	unsigned int m_recordStack[MaxScopeDepth];
+	unsigned int m_scopeStack[MaxScopeDepth];
+	unsigned int m_stackDepth;
+	std::vector<Scope> m_scopes;
+	std::atomic<unsigned long long> m_droppedFrames;
+
+	// Copy of the results for other threads, written once per resolved frame
+	mutable std::mutex m_statsMutex;
+	std::vector<ScopeStats> m_stats;
+	float m_lastFrameTime;
+};
+
+// Times the enclosing block, does nothing if there's no profiler
+class GpuProfileScope
+{
+public:
+	explicit GpuProfileScope(const char* a_name) : m_profiler(GpuProfiler::GetInstance())
+	{
+		if (m_profiler) { m_profiler->BeginScope(a_name); }
+	}
+	~GpuProfileScope()
+	{
+		if (m_profiler) { m_profiler->EndScope(); }
+	}
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+	GpuProfiler* m_profiler;
+};
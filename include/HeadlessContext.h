@@ -0,0 +1,41 @@
+#pragma once
+
+// An OpenGL context with no window, for benchmarking and batch rendering on machines without a display
+// The context is made with EGL on Mesa's surfaceless platform (llvmpipe works, so no GPU is needed either) and everything
+// is drawn into an offscreen framebuffer of the requested size, which stays bound as the draw target.
+// EGL is only used on Linux, Create returns nullptr elsewhere and the caller falls back to a hidden window.
+class HeadlessContext
+{
+public:
+	// Returns nullptr if no context could be made, the context is current on the calling thread on success
+	static HeadlessContext* Create(unsigned int a_width, unsigned int a_height);
+	~HeadlessContext();
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	// Pass to gladLoadGLLoader once the context is current
+	static void* GetProcAddress(const char* a_name);
+
+	// Create and bind the offscreen framebuffer, needs GL loaded
+	bool CreateFramebuffer();
+	// The context can be moved between threads like a window's, release it on one before making it current on another
+	bool MakeCurrent();
+	void ReleaseCurrent();
+	// Stands in for a buffer swap, waits for the GPU so frame times include the work like a vsync-less swap would
+	void Present();
+
+	unsigned int GetWidth() const { return m_width; }
+	unsigned int GetHeight() const { return m_height; }
+
+private:
+	HeadlessContext(unsigned int a_width, unsigned int a_height);
+
+	unsigned int m_width;
+	unsigned int m_height;
+	// EGL handles, kept as void* so EGL headers don't leak into everything that includes Application.h
+	void* m_display;
+	void* m_context;
+	unsigned int m_framebuffer;
+	unsigned int m_colourBuffer;
+	unsigned int m_depthBuffer;
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "MemoryStats.h"
+
+// Counts outstanding jobs, a job decrements its counter when it finishes
+// Wait on a counter to block until a batch is done, or pass it as a dependency so a job won't start until it hits zero
+class JobCounter
+{
+public:
+	JobCounter() : m_value(0) {}
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool IsDone() const { return m_value.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+	std::atomic<int> m_value;
+};
+
+// A unit of work, the callable is stored inline so submitting a job never allocates
+typedef struct alignas(64) Job
+{
+	static constexpr size_t PayloadSize = 32;
+	void (*execute)(Job* a_job);
+	JobCounter* counter;
+	const JobCounter* dependency;
+	// Allocation tag of the thread that queued it, so work done on a worker is counted against the right subsystem
+	MemoryStats::Tag memoryTag;
+	// Set while the job is queued or running, its ring slot can't be handed out again until it clears
+	std::atomic<bool> inUse{ false };
+	alignas(16) unsigned char payload[PayloadSize];
+} Job;
+
+// Fixed size Chase-Lev work stealing deque. The owning thread pushes and pops at the bottom,
+// any other thread steals from the top
+class JobDeque
+{
+public:
+	static constexpr long long Capacity = 4096;
+	JobDeque() : m_top(0), m_bottom(0) {}
+
+	bool Push(Job* a_job);
+	Job* Pop();
+	Job* Steal();
+	long long Size() const;
+
+private:
+	alignas(64) std::atomic<long long> m_top;
+	alignas(64) std::atomic<long long> m_bottom;
+	std::atomic<Job*> m_jobs[Capacity];
+};
+
+// Shared work stealing thread pool
+// The thread that creates the job system becomes worker 0 and helps run jobs whenever it waits, the rest are background
+// workers that each own a deque and steal from each other when they run dry. Only the pool's own threads can queue
+// jobs, any other thread runs what it submits inline
+// A job taken off a deque before its dependency has finished is parked on a shared list rather than pushed back, and
+// any thread runs it once the dependency's counter reaches zero
+class JobSystem
+{
+public:
+	static JobSystem* GetInstance() { return m_instance; }
+	static JobSystem* CreateInstance(unsigned int a_workerCount = DefaultWorkerCount())
+	{
+		if (m_instance == nullptr)
+		{
+			m_instance = new JobSystem(a_workerCount);
+		}
+		return m_instance;
+	}
+	static void DestroyInstance()
+	{
+		if (m_instance)
+		{
+			delete m_instance;
+			m_instance = nullptr;
+		}
+	}
+	// One background worker per core, leaving a core for the main thread
+	static unsigned int DefaultWorkerCount()
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		return cores > 1 ? cores - 1 : 0;
+	}
+
+	// a_workerCount background threads are started, the calling thread makes up the extra one
+	explicit JobSystem(unsigned int a_workerCount);
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Queue a callable, it must fit in Job::PayloadSize (capture pointers rather than big objects)
+	// If a_counter is set it is incremented now and decremented when the job finishes
+	// If a_dependency is set the job won't start until that counter reaches zero
+	template<typename Function>
+	void Run(Function&& a_function, JobCounter* a_counter = nullptr, const JobCounter* a_dependency = nullptr)
+	{
+		typedef typename std::decay<Function>::type Callable;
+		static_assert(sizeof(Callable) <= Job::PayloadSize, "Job callable is too big, capture less or by pointer");
+		static_assert(alignof(Callable) <= 16, "Job callable is over-aligned");
+
+		int index = ThreadIndex();
+		if (index < 0)
+		{
+			// Not one of our threads so there's no deque to push to, just run it here
+			if (a_dependency) { Wait(a_dependency); }
+			a_function();
+			return;
+		}
+		if (a_counter) { a_counter->m_value.fetch_add(1, std::memory_order_relaxed); }
+		Job* job = AllocateJob(index);
+		new (job->payload) Callable(std::forward<Function>(a_function));
+		job->execute = &ExecuteCallable<Callable>;
+		job->counter = a_counter;
+		job->dependency = a_dependency;
+		job->memoryTag = MemoryStats::GetThreadTag();
+		Submit(index, job);
+	}
+
+	// Split [0, a_count) into chunks of at least a_grainSize and run a_body(begin, end) on each in parallel
+	// Returns once every chunk has finished, the calling thread helps out
+	template<typename Body>
+	void ParallelFor(size_t a_count, size_t a_grainSize, const Body& a_body)
+	{
+		if (a_count == 0) { return; }
+		// Cap the number of chunks so one loop can't overrun the job ring
+		if (a_grainSize == 0) { a_grainSize = 1; }
+		size_t minGrain = (a_count + MaxParallelForChunks - 1) / MaxParallelForChunks;
+		if (a_grainSize < minGrain) { a_grainSize = minGrain; }
+
+		JobCounter counter;
+		const Body* body = &a_body;
+		for (size_t begin = 0; begin < a_count; begin += a_grainSize)
+		{
+			size_t end = begin + a_grainSize < a_count ? begin + a_grainSize : a_count;
+			Run([body, begin, end]() { (*body)(begin, end); }, &counter);
+		}
+		Wait(&counter);
+	}
+	// As above but picks a grain size that gives each thread a handful of chunks
+	template<typename Body>
+	void ParallelFor(size_t a_count, const Body& a_body)
+	{
+		size_t chunks = (size_t)GetThreadCount() * 4;
+		ParallelFor(a_count, (a_count + chunks - 1) / chunks, a_body);
+	}
+
+	// Run jobs on this thread until the counter reaches zero
+	void Wait(const JobCounter* a_counter);
+	// Run a single queued job on this thread if there is one, for callers that wait on something other than a counter
+	bool ExecutePendingJob();
+
+	// Index of the calling thread in this job system (0 is the owning thread) or -1 if it isn't one of ours
+	int GetThreadIndex() const { return ThreadIndex(); }
+	// Background workers plus the owning thread
+	unsigned int GetThreadCount() const { return (unsigned int)m_workers.size(); }
+	unsigned long long GetStealCount() const { return m_steals.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr size_t JobRingSize = 4096;		// Jobs in flight per submitting thread, submitting more waits for the oldest
+	static constexpr size_t MaxParallelForChunks = 1024;
+
+	typedef struct WorkerData
+	{
+		JobDeque deque;
+		Job jobs[JobRingSize];
+		size_t nextJob = 0;
+	} WorkerData;
+
+	template<typename Callable>
+	static void ExecuteCallable(Job* a_job)
+	{
+		Callable* callable = std::launder(reinterpret_cast<Callable*>(a_job->payload));
+		(*callable)();
+		callable->~Callable();
+	}
+
+	// Index of the calling thread in this job system or -1 if it isn't one of ours
+	int ThreadIndex() const;
+	Job* AllocateJob(int a_index);
+	void Submit(int a_index, Job* a_job);
+	// Find and run one job, returns false if there was nothing to do
+	bool ExecuteOne(int a_index);
+	void Execute(Job* a_job);
+	// Park a job until its dependency is done, and take back one that's now ready
+	void Block(Job* a_job);
+	Job* TakeUnblockedJob();
+	// Bump the job generation so sleeping workers look for work again
+	void WakeWorkers();
+	void WorkerLoop(unsigned int a_index);
+
+	static JobSystem* m_instance;
+
+	std::vector<WorkerData*> m_workers;
+	std::vector<std::thread> m_threads;
+	std::atomic<bool> m_running;
+	std::atomic<unsigned long long> m_steals;
+
+	// Idle workers sleep here, m_jobGeneration changes whenever a job is submitted
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	std::atomic<unsigned int> m_sleepingWorkers;
+	std::atomic<unsigned long long> m_jobGeneration;
+
+	// Jobs waiting on a dependency, reserved up front so parking doesn't allocate in the common case
+	std::mutex m_blockedMutex;
+	std::vector<Job*> m_blockedJobs;
+	std::atomic<unsigned int> m_blockedCount;
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+
+// A read-only view of a file mapped into memory
+// Lets loaders hash and decode file contents without copying them into a heap buffer first
+
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+	// Copying a mapping would lead to a double unmap so it has been disabled for this class
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Map the file at the given path, returns false if the file cannot be opened or is empty
+	bool Open(const char* a_filename);
+	// Unmap the view and close any OS handles
+	void Close();
+
+	bool					IsOpen()	const { return m_data != nullptr; }
+	const unsigned char*	GetData()	const { return m_data; }
+	size_t					GetSize()	const { return m_size; }
+
+private:
+	const unsigned char*	m_data;
+	size_t					m_size;
+#ifdef _WIN32
+	void*					m_fileHandle;
+	void*					m_mappingHandle;
+#endif
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+
+// Counts every general purpose heap allocation made through operator new
+// The global new/delete operators are replaced in MemoryStats.cpp so this covers the STL and our own code, it doesn't
+// see direct malloc calls (stb_image, the TGA decoder, the frame arenas' own blocks) or over-aligned new.
+// Each allocation carries a small header with its size and the subsystem tag that was current on the allocating thread,
+// so live and peak bytes can be tracked per subsystem and anything still allocated at shutdown reported.
+class MemoryStats
+{
+public:
+	enum Tag
+	{
+		General,
+		Loader,
+		Textures,
+		Shaders,
+		Events,
+		UI,
+		Renderer,
+		Profiling,
+		// Allocations the GL driver makes through our new (Mesa/LLVM JIT state), caches it keeps until process exit
+		Driver,
+		Tag_Count
+	};
+
+	typedef struct TagStats
+	{
+		long long liveBytes;
+		long long peakBytes;
+		long long liveAllocations;
+		unsigned long long totalAllocations;
+	} TagStats;
+
+	// Total calls to operator new since startup
+	static unsigned long long GetAllocationCount();
+	static long long GetLiveBytes();
+	static long long GetPeakBytes();
+	static TagStats GetTagStats(Tag a_tag);
+	static const char* GetTagName(Tag a_tag);
+
+	// Tag new allocations on the calling thread with a_tag, returns the previous tag. MemoryTagScope is the usual way in
+	static Tag SetThreadTag(Tag a_tag);
+	static Tag GetThreadTag();
+
+	// Allocation routed through the tracking for code with its own allocator hooks (ImGui)
+	static void* Allocate(size_t a_size, Tag a_tag);
+	static void Free(void* a_memory);
+
+	// Remember what's live now, anything allocated before this (static initialisers, context creation) isn't a leak.
+	// Freeing one of those later takes it off the baseline too, so it can't hide a real leak under the same tag
+	static void MarkBaseline();
+	// Print per subsystem whatever is still allocated beyond the baseline, returns true if anything is.
+	// Driver is left out, the driver doesn't free its caches before exit and that isn't ours to fix
+	static bool ReportLeaks();
+};
+
+// Tags allocations made on this thread for the lifetime of the scope
+class MemoryTagScope
+{
+public:
+	explicit MemoryTagScope(MemoryStats::Tag a_tag) : m_previous(MemoryStats::SetThreadTag(a_tag)) {}
+	~MemoryTagScope() { MemoryStats::SetThreadTag(m_previous); }
+	MemoryTagScope(const MemoryTagScope&) = delete;
+	MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+private:
+	MemoryStats::Tag m_previous;
+};
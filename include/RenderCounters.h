@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+
+// Per frame counts of the GL work the renderer issues
+// Every path that draws, binds or uploads bumps a counter with RENDER_COUNT, EndFrame then publishes the totals for
+// the overlay and telemetry and starts the next frame from zero.
+// Counting happens on the thread that owns the GL context so the running totals are plain integers, only the published
+// copy is shared. Turned off at runtime each RENDER_COUNT is one relaxed load, defining RENDER_COUNTERS_DISABLED removes them.
+class RenderCounters
+{
+public:
+	enum Counter
+	{
+		DrawCalls,
+		Triangles,
+		Lines,
+		ProgramBinds,
+		TextureBinds,
+		BufferBinds,
+		VertexArrayBinds,
+		UniformUpdates,
+		StateChanges,			// Enable/disable, depth state and vertex attribute toggles
+		BufferUploads,
+		BufferBytesUploaded,
+		TextureUploads,
+		TextureBytesUploaded,
+		Counter_Count
+	};
+
+	static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+	static void SetEnabled(bool a_enabled) { s_enabled.store(a_enabled, std::memory_order_relaxed); }
+
+	// GL thread only
+	static void Add(Counter a_counter, unsigned long long a_amount = 1) { s_current[a_counter] += a_amount; }
+	// Call on the GL thread once the frame has been submitted
+	static void EndFrame();
+
+	// Totals for the last finished frame, safe to call from any thread
+	static void GetLastFrame(unsigned long long (&a_counters)[Counter_Count]);
+	// Frames published since startup, lets a reader tell whether the totals have changed
+	static unsigned long long GetFrameIndex();
+	static const char* GetName(Counter a_counter);
+
+private:
+	static std::atomic<bool> s_enabled;
+	static unsigned long long s_current[Counter_Count];
+};
+
+#ifndef RENDER_COUNTERS_DISABLED
+#define RENDER_COUNT(counter, amount) do { if (RenderCounters::IsEnabled()) { RenderCounters::Add(RenderCounters::counter, (amount)); } } while (0)
+#else
+#define RENDER_COUNT(counter, amount) do {} while (0)
+#endif
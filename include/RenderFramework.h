@@ -1,12 +1,22 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <string>
+#include <vector>
 
 #include "Application.h"
 #include <ApplicationEvent.h>
+#include "Dispatcher.h"
+#include "FrameGraph.h"
+#include "ShaderUtil.h"
+#include "TextureManager.h"
+#include "BufferManager.h"
+#include "GpuMemory.h"
 //Forward declare OBJ model
 
 class OBJModel;
+class OBJMesh;
+class OBJMaterial;
 
 class RenderFramework : public Application
 {
@@ -19,12 +29,17 @@ public:
 	void ChangeBackgroundColour(glm::vec3* a_backgroundColour, glm::vec3* a_specularTint);
 	void SaveBackgroundColour(glm::vec3 &a_backgroundColour, glm::vec3 a_newBackgroundColour);
 	void MainMenu(bool& m_bMy_tool_active);
+	// Frame time series, histogram and percentiles from FrameStats
+	void FrameStatsWindow();
+	// OBJ file loaded by onCreate, set before calling Run
+	void SetModelPath(const std::string& a_path) { m_modelPath = a_path; }
 
 protected:
 	virtual bool onCreate();
 	virtual void Update(float deltaTime);
 	virtual void Draw();
 	virtual void Destroy();
+	virtual void CaptureFrame(unsigned int a_slot);
 
 private:
 	// Structure for a simple vertex - interleaved (position, colour)
@@ -41,31 +56,124 @@ private:
 		Vertex v1;
 	}Line;
 
-	Line* m_lines;
+	// Resources the frame graph tasks read and write, used to order the tasks
+	enum FrameResources : FrameGraph::Resource
+	{
+		CameraResource,			// Camera matrix, projection-view and frustum planes
+		SettingsResource,		// Anything the ImGui windows edit
+		VisibilityResource,		// Per mesh visibility flags
+		DrawListResource,		// Visible meshes in draw order
+		DrawCommandsResource	// Per draw state ready for GL submission
+	};
+
+	// Features that select which variant of the obj shader a material is drawn with, see obj_fragment.glsl
+	enum ObjShaderFeatures : unsigned int
+	{
+		DiffuseMapFeature	= 1 << 0,
+		SpecularMapFeature	= 1 << 1,
+		NormalMapFeature	= 1 << 2,
+		SpecularFeature		= 1 << 3,
+		AlphaTestFeature	= 1 << 4,
+		TextureArrayFeature	= 1 << 5,
+		ObjShaderFeatures_Count = 6
+	};
+	unsigned int GetMaterialFeatures(const OBJMaterial* a_pMaterial) const;
+
+	// Model space bounding box of a mesh
+	typedef struct MeshBounds
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+	}MeshBounds;
+
+	// Everything the GL submission needs for one mesh, built on the worker threads
+	typedef struct DrawCommand
+	{
+		OBJMesh* mesh;
+		glm::vec4 kA;
+		glm::vec4 kD;
+		glm::vec4 kS;
+		unsigned int textureIDs[3];		// Diffuse, specular, normal
+		unsigned int textureLayers[3];
+		unsigned int features;			// ObjShaderFeatures mask, picks the shader variant
+		bool hasMaterial;
+	}DrawCommand;
+
+	// Everything Draw reads, captured once per frame so the render thread never touches live state
+	typedef struct FrameSnapshot
+	{
+		glm::mat4 projectionViewMatrix;
+		glm::vec4 cameraPosition;
+		glm::vec3 backgroundColour;
+		glm::vec3 specularTint;
+		glm::vec3 lightDirection;
+		int viewportWidth;
+		int viewportHeight;
+		std::vector<DrawCommand> drawCommands;
+	}FrameSnapshot;
+
+	// Frame graph tasks
+	void SetupFrameGraph();
+	void UpdateCamera();
+	void UpdateUI();
+	void CullMeshes();
+	void SortDrawList();
+	void BuildDrawCommands();
+
+	Line* m_lines = nullptr;
 	glm::mat4 m_cameraMatrix;
 	glm::mat4 m_projectionMatrix;
+	glm::mat4 m_projectionViewMatrix;
+	glm::vec4 m_frustumPlanes[6];
 
-	unsigned int m_uiProgram;
-	unsigned int m_objProgram; // Variable for the shader program
-	unsigned int m_lineVBO;
-	unsigned int m_objModelBuffer[2]; // Used for the index and vertex buffer of the model
+	ProgramHandle m_uiProgram;
+	BufferHandle m_lineVBO;
+	BufferHandle m_objModelBuffer[2]; // Used for the index and vertex buffer of the model
 
 	// Model
 	OBJModel* m_objModel;
-	Line* lines;
+	std::string m_modelPath = "resource/models/D0208009.obj";
+	// Pack material textures into per-role texture arrays (bucketed by size) so draws don't rebind textures per material
+	bool m_useTextureArrays = true;
+	// References taken on the material textures, released on destroy
+	std::vector<TextureHandle> m_materialTextures;
+	// Handle for our window resize subscription so we can unsubscribe on destroy
+	SubscriptionHandle m_resizeSubscription{};
+
+	// Update runs this each frame, the tasks fill in the draw commands that Draw submits
+	FrameGraph m_frameGraph;
+	float m_deltaTime = 0.f;
+	std::vector<MeshBounds> m_meshBounds;
+	std::vector<unsigned char> m_meshVisible;
+	// ObjShaderFeatures for each mesh's material
+	std::vector<unsigned int> m_meshFeatures;
+	// Visible mesh indices in draw order, lives in the frame allocator so only valid during Update
+	unsigned int* m_drawList = nullptr;
+	unsigned int m_drawListCount = 0;
+	std::vector<DrawCommand> m_drawCommands;
+	// Triple buffered snapshots for Draw, see Application::CaptureFrame
+	FrameSnapshot m_snapshots[3];
+	int m_viewportWidth = 0;
+	int m_viewportHeight = 0;
 	glm::vec3 m_specularTint;
+	glm::vec3 m_lightDirection = glm::vec3(-10.f, -8.f, -10.f);
 	glm::vec3 m_backgroundColour;
 
 
 	// Skybox rendering 
-	unsigned int m_CubeMaptextID;
+	TextureHandle m_CubeMapTexture;
 	unsigned int m_SBVAO;
-	unsigned int m_SBVBO;
-	unsigned int m_SBProgramID;
+	BufferHandle m_SBVBO;
+	ProgramHandle m_SBProgram;
 
 	// ImGui
 	bool m_bMy_tool_active = true;
 	bool m_changeColour = false;
+	bool m_showFrameStats = false;
+	// Reused between frames so drawing the stats window doesn't allocate once they've grown
+	std::vector<float> m_frameSamples;
+	std::vector<float> m_frameBins;
+	std::vector<GpuMemory::Allocation> m_gpuAllocations;
 };
 
 
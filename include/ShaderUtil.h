@@ -1,5 +1,13 @@
 #pragma once
-#include <vector>
+#include <string>
+#include <unordered_map>
+#include "SlotMap.h"
+
+struct ShaderTag;
+struct ProgramTag;
+// Handles to shaders and programs owned by ShaderUtil, resolve them to GL names with getShaderID/getProgramID
+typedef Handle<ShaderTag> ShaderHandle;
+typedef Handle<ProgramTag> ProgramHandle;
 
 class ShaderUtil
 {
@@ -8,22 +16,93 @@ public:
 	static ShaderUtil* CreateInstance();
 	static ShaderUtil* GetInstance();
 	static void DestroyInstance();
-	static unsigned int loadShader(const char* a_filename, unsigned int a_type);
-	static void deleteShader(unsigned int a_shaderID);
-	static unsigned int createProgram(const int& a_vertexShader, const int& a_fragmentShader);
-	static void deleteProgram(unsigned int a_program);
+	static ShaderHandle loadShader(const char* a_filename, unsigned int a_type);
+	static void deleteShader(ShaderHandle a_shader);
+	static ProgramHandle createProgram(ShaderHandle a_vertexShader, ShaderHandle a_fragmentShader);
+	static void deleteProgram(ProgramHandle a_program);
+	// Load, compile and link a vertex/fragment pair in one go. Sources go through a small preprocessor that
+	// expands #include "file" (relative to the including file) and injects a_defines after the #version line.
+	// Linked programs are cached on disk as driver binaries, keyed on the source, defines and driver, so
+	// repeat launches skip compilation entirely. Any mismatch falls back to compiling from source.
+	static ProgramHandle loadProgram(const char* a_vertexFile, const char* a_fragmentFile, const char* a_defines = "");
+	// Non-blocking loadProgram, the compile and link are submitted straight away and the handle resolves
+	// to 0 until pollPrograms sees it finish. Where GL_KHR_parallel_shader_compile is available the driver
+	// builds on its own threads, otherwise the remaining work is done on the next poll.
+	static ProgramHandle loadProgramAsync(const char* a_vertexFile, const char* a_fragmentFile, const char* a_defines = "");
+	// Specialised variant of a program, bit n of a_featureMask adds "#define a_featureNames[n]".
+	// Variants are built asynchronously the first time a mask is asked for and cached after that.
+	static ProgramHandle getProgramVariant(const char* a_vertexFile, const char* a_fragmentFile, unsigned int a_featureMask, const char* const* a_featureNames, unsigned int a_featureCount);
+	// Advance any pending programs, call once a frame from the thread that owns the GL context
+	static void pollPrograms();
+	static bool isProgramReady(ProgramHandle a_program);
+	static bool hasPendingPrograms();
+	// GL names for a handle, 0 if the handle is null, has been deleted or (for programs) isn't ready yet
+	static unsigned int getShaderID(ShaderHandle a_shader);
+	static unsigned int getProgramID(ProgramHandle a_program);
 
 private:
 	// Private Constructor and Destructor
 	ShaderUtil();
 	~ShaderUtil();
 
-	std::vector<unsigned int> mShaders;
-	std::vector<unsigned int> mPrograms;
+	SlotMap<unsigned int, ShaderTag> mShaders;
+	enum ProgramStatus
+	{
+		ProgramCompiling,
+		ProgramLinking,
+		ProgramReady,
+		ProgramFailed
+	};
+	typedef struct ProgramRecord
+	{
+		unsigned int program;
+		// Shader objects are only held while the program is being built
+		unsigned int vertexShader;
+		unsigned int fragmentShader;
+		ProgramStatus status;
+		// Binary cache key, 0 when the program shouldn't be written to the cache
+		unsigned long long cacheKey;
+		std::string vertexName;
+		std::string fragmentName;
+	} ProgramRecord;
+	SlotMap<ProgramRecord, ProgramTag> mPrograms;
+	unsigned int mPendingPrograms;
+	// Program variants keyed on a hash of the two file paths and the feature mask
+	std::unordered_map<unsigned long long, ProgramHandle> mVariants;
+
+	ShaderHandle loadShaderInternal(const char* a_fileName, unsigned int a_type);
+	void deleteShaderInternal(ShaderHandle a_shader);
+	ProgramHandle createProgramInternal(ShaderHandle a_vertexShader, ShaderHandle a_fragmentShader);
+	void deleteProgramInternal(ProgramHandle a_program);
+	ProgramHandle loadProgramInternal(const char* a_vertexFile, const char* a_fragmentFile, const char* a_defines, bool a_block);
+	// Move a pending program on as far as it can go, a_block waits on the driver instead of checking for completion
+	void advanceProgram(ProgramRecord& a_record, bool a_block);
+	void pollProgramsInternal();
+
+	// Returns the GL shader name, 0 if it failed to compile
+	unsigned int compileShaderSource(const char* a_source, const char* a_name, unsigned int a_type);
+	// Returns the GL program name, 0 if it failed to link
+	unsigned int linkProgram(unsigned int a_vertexShader, unsigned int a_fragmentShader, bool a_retrievable);
+	// The two halves of the above, so the async path can submit now and check later
+	unsigned int submitShader(const char* a_source, unsigned int a_type);
+	bool checkShaderCompiled(unsigned int a_shader, const char* a_name);
+	unsigned int submitProgram(unsigned int a_vertexShader, unsigned int a_fragmentShader, bool a_retrievable);
+	bool checkProgramLinked(unsigned int a_program);
+
+	// Query the driver once for binary and parallel compile support, needs a current GL context
+	void initialiseDriverInfo();
 
-	unsigned int loadShaderInternal(const char* a_fileName, unsigned int a_type);
-	void deleteShaderInternal(unsigned int a_shaderID);
-	unsigned int createProgramInternal(const int& a_vertexShader, const int& a_fragmentShader);
-	void deleteProgramInternal(unsigned int a_program);
+	// Program binary cache
+	std::string getCachePath(unsigned long long a_key) const;
+	unsigned int loadCachedProgram(unsigned long long a_key);
+	void saveCachedProgram(unsigned long long a_key, unsigned int a_program);
+	// Hash of the GL vendor, renderer and version strings, binaries from another driver won't load
+	unsigned long long mDriverHash;
+	// Drivers are allowed to report zero binary formats, in which case we always compile
+	bool mBinaryCacheSupported;
+	// GL_KHR_parallel_shader_compile (or the ARB version) lets us poll GL_COMPLETION_STATUS_KHR
+	bool mParallelCompile;
+	unsigned int mCacheHits;
+	unsigned int mCacheMisses;
 	static ShaderUtil* mInstance;
 };
@@ -0,0 +1,159 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// Generational handle into a SlotMap. The tag type only exists so handles for
+// different resource types can't be mixed up, e.g. passing a texture to a buffer call
+template<typename Tag>
+struct Handle
+{
+	uint32_t index = 0;
+	// Generation 0 is never handed out so a default constructed handle is always invalid
+	uint32_t generation = 0;
+
+	bool IsValid() const { return generation != 0; }
+	bool operator==(const Handle& a_rhs) const { return index == a_rhs.index && generation == a_rhs.generation; }
+	bool operator!=(const Handle& a_rhs) const { return !(*this == a_rhs); }
+};
+
+// Dense slot map with O(1) insert, lookup and remove.
+// Values are kept packed in one vector so iterating a resource table walks contiguous memory,
+// the sparse slot array maps a handle's index to the value's current dense position.
+// Removing bumps the slot generation so any handle still pointing at it goes stale rather than
+// silently resolving to whatever gets inserted into the slot next.
+template<typename T, typename Tag>
+class SlotMap
+{
+public:
+	typedef Handle<Tag> HandleType;
+
+	HandleType Insert(const T& a_value) { return Emplace(a_value); }
+	HandleType Insert(T&& a_value) { return Emplace(std::move(a_value)); }
+
+	template<typename... Args>
+	HandleType Emplace(Args&&... a_args)
+	{
+		uint32_t slotIndex;
+		if (m_freeHead != InvalidIndex)
+		{
+			slotIndex = m_freeHead;
+			m_freeHead = m_slots[slotIndex].target;
+		}
+		else
+		{
+			slotIndex = (uint32_t)m_slots.size();
+			m_slots.push_back(Slot{ InvalidIndex, 1 });
+		}
+		Slot& slot = m_slots[slotIndex];
+		slot.target = (uint32_t)m_values.size();
+		m_values.emplace_back(std::forward<Args>(a_args)...);
+		m_valueSlots.push_back(slotIndex);
+		return HandleType{ slotIndex, slot.generation };
+	}
+
+	// Returns nullptr for stale or invalid handles
+	T* Get(HandleType a_handle)
+	{
+		if (!Contains(a_handle))
+		{
+			ReportStale(a_handle);
+			return nullptr;
+		}
+		return &m_values[m_slots[a_handle.index].target];
+	}
+	const T* Get(HandleType a_handle) const
+	{
+		return const_cast<SlotMap*>(this)->Get(a_handle);
+	}
+
+	bool Contains(HandleType a_handle) const
+	{
+		return a_handle.IsValid() && a_handle.index < m_slots.size() && m_slots[a_handle.index].generation == a_handle.generation;
+	}
+
+	// Swaps the last value into the hole so the values stay packed
+	bool Remove(HandleType a_handle)
+	{
+		if (!Contains(a_handle))
+		{
+			ReportStale(a_handle);
+			return false;
+		}
+		Slot& slot = m_slots[a_handle.index];
+		uint32_t denseIndex = slot.target;
+		uint32_t lastIndex = (uint32_t)m_values.size() - 1;
+		if (denseIndex != lastIndex)
+		{
+			m_values[denseIndex] = std::move(m_values[lastIndex]);
+			m_valueSlots[denseIndex] = m_valueSlots[lastIndex];
+			m_slots[m_valueSlots[denseIndex]].target = denseIndex;
+		}
+		m_values.pop_back();
+		m_valueSlots.pop_back();
+		// Skip generation 0 on wrap around so it stays reserved for invalid handles
+		if (++slot.generation == 0) { slot.generation = 1; }
+		slot.target = m_freeHead;
+		m_freeHead = a_handle.index;
+		return true;
+	}
+
+	void Clear()
+	{
+		for (uint32_t denseIndex = 0; denseIndex < m_valueSlots.size(); ++denseIndex)
+		{
+			Slot& slot = m_slots[m_valueSlots[denseIndex]];
+			if (++slot.generation == 0) { slot.generation = 1; }
+			slot.target = m_freeHead;
+			m_freeHead = m_valueSlots[denseIndex];
+		}
+		m_values.clear();
+		m_valueSlots.clear();
+	}
+
+	// Handle for the value at a dense position, for when iteration needs to hand out handles
+	HandleType GetHandleAt(size_t a_denseIndex) const
+	{
+		uint32_t slotIndex = m_valueSlots[a_denseIndex];
+		return HandleType{ slotIndex, m_slots[slotIndex].generation };
+	}
+
+	size_t Size() const { return m_values.size(); }
+	bool Empty() const { return m_values.empty(); }
+
+	// Iteration walks the packed values, order changes whenever something is removed
+	typename std::vector<T>::iterator begin() { return m_values.begin(); }
+	typename std::vector<T>::iterator end() { return m_values.end(); }
+	typename std::vector<T>::const_iterator begin() const { return m_values.begin(); }
+	typename std::vector<T>::const_iterator end() const { return m_values.end(); }
+
+private:
+	static constexpr uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+	typedef struct Slot
+	{
+		uint32_t target;		// Dense index while alive, next free slot while on the free list
+		uint32_t generation;
+	} Slot;
+
+	void ReportStale(HandleType a_handle) const
+	{
+#ifndef NDEBUG
+		// Same switch as assert, so every compiler's debug build reports them. A null handle is a normal "nothing loaded" value, anything else is a use after free
+		if (a_handle.IsValid())
+		{
+			std::cout << "Stale resource handle used (index " << a_handle.index << ", generation " << a_handle.generation << ")" << std::endl;
+			assert(false && "Stale resource handle");
+		}
+#else
+		(void)a_handle;
+#endif
+	}
+
+	std::vector<T> m_values;
+	std::vector<uint32_t> m_valueSlots;	// Dense index -> slot index, used to patch the slot of the value moved by Remove
+	std::vector<Slot> m_slots;
+	uint32_t m_freeHead = InvalidIndex;
+};
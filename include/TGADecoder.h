@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+
+// A dedicated decoder for the TGA variants our model textures are exported as (uncompressed or RLE, 24/32 bit true colour)
+// Works directly on the file bytes (e.g. a MappedFile) and writes rows straight into their final position using the
+// TGA origin bit, so no separate vertical flip or channel expansion pass is needed.
+
+class TGADecoder
+{
+public:
+	// Decode into tightly packed RGBA8 pixels. a_flipVertically requests bottom row first (OpenGL's convention).
+	// Returns nullptr for files this decoder does not handle (colour mapped, greyscale, right-to-left, corrupt)
+	// so callers can fall back to a generic decoder. The result is allocated with malloc and released with free().
+	static unsigned char* Decode(const unsigned char* a_data, size_t a_size, int& a_width, int& a_height, bool a_flipVertically);
+
+private:
+	TGADecoder() = delete;
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "RenderCounters.h"
+#include "GpuMemory.h"
+
+// Where and how Telemetry writes, nothing is recorded unless Telemetry::CreateInstance is called with one of these
+typedef struct TelemetryConfig
+{
+	enum Format { Csv, JsonLines };
+	enum Interval { PerFrame, PerSecond };
+
+	// Output file, appended to. Ignored when socketPath is set
+	std::string path = "telemetry.csv";
+	// Local UNIX stream socket to send records to instead of a file (not available on Windows)
+	std::string socketPath;
+	Format format = Csv;
+	Interval interval = PerFrame;
+} TelemetryConfig;
+
+// Everything the main loop knows about a finished frame
+typedef struct TelemetryFrame
+{
+	float cpuMs;
+	unsigned long long heapAllocations;
+	long long heapLiveBytes;
+	size_t frameArenaBytes;
+} TelemetryFrame;
+
+// Performance records for scraping, one per frame or per second
+// The main loop fills in a record and pushes it into a bounded lock-free ring; a background thread drains the ring every
+// so often, formats the records and writes them out. Pushing never blocks or allocates, if the writer falls behind and the
+// ring fills up records are dropped and counted rather than stalling the frame.
+class Telemetry
+{
+public:
+	// Returns nullptr if the output couldn't be opened
+	static Telemetry* CreateInstance(const TelemetryConfig& a_config);
+	static Telemetry* GetInstance() { return m_instance; }
+	// Writes anything still queued then stops the writer thread
+	static void DestroyInstance();
+
+	// Call from the main thread at the end of each frame
+	void RecordFrame(const TelemetryFrame& a_frame);
+	// How long a load phase took, a_name must outlive the telemetry (string literals)
+	void RecordLoadPhase(const char* a_name, float a_ms);
+
+	unsigned long long GetDroppedRecords() const { return m_dropped.load(std::memory_order_relaxed); }
+
+	static const unsigned int QueueCapacity = 1024;
+
+private:
+	Telemetry(const TelemetryConfig& a_config);
+	~Telemetry();
+	static Telemetry* m_instance;
+
+	typedef struct Record
+	{
+		enum Type { Frame, Interval, LoadPhase } type;
+		unsigned long long frame;
+		double time;				// Seconds since telemetry started
+		unsigned int frameCount;	// Frames the record covers, 1 for per frame records
+		float cpuMs;				// Average over the frames covered
+		float gpuMs;
+		float cpuP50, cpuP95, cpuP99, cpuMax;
+		float gpuP50, gpuP95, gpuP99, gpuMax;
+		unsigned int hitches;
+		unsigned long long counters[RenderCounters::Counter_Count];	// Summed over the frames covered
+		unsigned long long heapAllocations;
+		long long heapLiveBytes;
+		size_t frameArenaBytes;
+		size_t gpuMemory[GpuMemory::Category_Count];	// At the end of the frames covered
+		size_t gpuMemoryTotal;
+		const char* phase;
+		float phaseMs;
+	} Record;
+
+	// Same scheme as EventChannel, each slot's sequence says whether it's free for a producer or ready for the writer
+	typedef struct alignas(64) Slot
+	{
+		std::atomic<size_t> sequence;
+		Record record;
+	} Slot;
+
+	bool Open();
+	void Push(const Record& a_record);
+	void WriterLoop();
+	// Writer thread only
+	size_t Drain(std::string& a_buffer);
+	void Format(const Record& a_record, std::string& a_buffer) const;
+	void Write(const std::string& a_buffer);
+	bool ConnectSocket();
+	void CloseOutput();
+	double Now() const;
+
+	TelemetryConfig m_config;
+	std::chrono::steady_clock::time_point m_startTime;
+
+	Slot* m_slots;
+	alignas(64) std::atomic<size_t> m_enqueuePos;
+	alignas(64) size_t m_dequeuePos;
+	std::atomic<unsigned long long> m_dropped;
+
+	// Main thread state for building records
+	unsigned long long m_frameIndex;
+	unsigned long long m_lastCounterFrame;
+	Record m_interval;
+	double m_intervalStart;
+
+	// Writer thread state
+	FILE* m_file;
+	int m_socket;
+	double m_lastConnectAttempt;
+	std::string m_counterKeys[RenderCounters::Counter_Count];
+	std::string m_gpuMemoryKeys[GpuMemory::Category_Count];
+
+	std::thread m_writer;
+	std::mutex m_stopMutex;
+	std::condition_variable m_stopSignal;
+	bool m_stopping;
+};
+
+// Reports how long the enclosing block took as a load phase, does nothing without telemetry
+class TelemetryLoadPhase
+{
+public:
+	explicit TelemetryLoadPhase(const char* a_name) : m_name(a_name), m_start(std::chrono::steady_clock::now()) {}
+	~TelemetryLoadPhase()
+	{
+		if (Telemetry* telemetry = Telemetry::GetInstance())
+		{
+			telemetry->RecordLoadPhase(m_name, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_start).count());
+		}
+	}
+	TelemetryLoadPhase(const TelemetryLoadPhase&) = delete;
+	TelemetryLoadPhase& operator=(const TelemetryLoadPhase&) = delete;
+
+private:
+	const char* m_name;
+	std::chrono::steady_clock::time_point m_start;
+};
@@ -2,6 +2,8 @@
 #include <string>
 #include <vector>
 
+class MappedFile;
+
 // A class to store texture data
 // A texture is a data buffer that contains values which relate to pixel colours
 
@@ -12,19 +14,36 @@ public:
 	~Texture();
 
 	// Function to load a texture from file
-	bool Load(std::string a_filename);
+	// a_sRGB selects an sRGB internal format for colour maps so the sampler returns linear values,
+	// data maps (specular, normal) should stay linear
+	bool Load(std::string a_filename, bool a_sRGB = false);
+	// Function to load a texture from file data already in memory (e.g. a mapped file), a_filename is kept for lookups
+	bool LoadFromMemory(const std::string& a_filename, const unsigned char* a_data, size_t a_size, bool a_sRGB = false);
 	void unload();
 	// Get file name
 	const std::string& GetFileName() const { return m_filename; }
 	unsigned int GetTextureID() const { return m_textureID; }
 	void GetDimensions(unsigned int& a_w, unsigned int& a_h) const;
 	unsigned int LoadCubeMap(std::vector<std::string> a_filenames, unsigned int* cubemap_face_id);
+	// Function to load a cubemap from six mapped face files, faces are decoded concurrently and stored with a full mip chain
+	bool LoadCubeMapFromMemory(const std::string& a_name, const MappedFile* a_faces, const unsigned int* cubemap_face_id);
+	// Function to build a GL_TEXTURE_2D_ARRAY from same sized RGBA8 images, one layer per image
+	bool LoadArray(const std::string& a_name, unsigned int a_width, unsigned int a_height, const std::vector<const unsigned char*>& a_layers, bool a_sRGB = false);
+	bool IsCubeMap() const { return m_cubeMap; }
+	unsigned int GetLayerCount() const { return m_layerCount; }
+
+	// Decode an image file held in memory into tightly packed RGBA8 pixels, release the result with FreeImageData
+	// The filename extension selects a dedicated decoder where one exists (.tga), otherwise stb_image is used
+	static unsigned char* DecodeImage(const std::string& a_filename, const unsigned char* a_data, size_t a_size, int& a_width, int& a_height, bool a_flipVertically);
+	static void FreeImageData(unsigned char* a_pixels);
 
 private:
 	std::string m_filename;
 	unsigned int m_width;
 	unsigned int m_height;
 	unsigned int m_textureID;
+	unsigned int m_layerCount;
+	bool m_cubeMap;
 };
 
 inline void Texture::GetDimensions(unsigned int& a_w, unsigned int& a_h) const
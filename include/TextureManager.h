@@ -1,9 +1,15 @@
 #pragma once
 #include <map>
 #include <string>
+#include <vector>
+#include "SlotMap.h"
 
 class Texture; //Forward declare Texture as we only need to keep a pointer here and this avoids cyclic dependency.
 
+struct TextureTag;
+// Handle to a texture owned by the TextureManager, resolve it with GetTextureID when binding
+typedef Handle<TextureTag> TextureHandle;
+
 class TextureManager
 {
 public:
@@ -13,12 +19,29 @@ public:
 	static TextureManager* GetInstance();
 	static void DestroyInstance();
 	
-	bool TextureExists(const char* a_pName);
+	bool TextureExists(const char* a_pName, bool a_sRGB = false);
 	
 	//load a texture from file --> calls Texture::load()
-	unsigned int	LoadTexture(const char* a_pfilename);
-	unsigned int	GetTexture(const char* a_filename);
-	void			ReleaseTexture(unsigned int a_texture);
+	// a_sRGB should be set for colour maps (diffuse), the same file loaded as sRGB and as linear are separate textures
+	TextureHandle	LoadTexture(const char* a_pfilename, bool a_sRGB = false);
+	// load a cubemap from six face files in +X, -X, +Y, -Y, +Z, -Z order --> calls Texture::LoadCubeMapFromMemory()
+	TextureHandle	LoadCubeMap(const std::vector<std::string>& a_faceFilenames);
+	// Where a file ended up after packing into a texture array: the GL_TEXTURE_2D_ARRAY texture and the layer within it
+	typedef struct TextureArraySlot
+	{
+		TextureHandle texture;
+		unsigned int layer;
+	} TextureArraySlot;
+	// Pack files into GL_TEXTURE_2D_ARRAY textures, one array per distinct image size.
+	// a_slots receives one entry per filename (empty or unreadable files get a null handle)
+	void			LoadTextureArrays(const std::vector<std::string>& a_filenames, std::vector<TextureArraySlot>& a_slots, bool a_sRGB = false);
+	TextureHandle	GetTexture(const char* a_filename, bool a_sRGB = false);
+	void			ReleaseTexture(TextureHandle a_texture);
+	// GL texture name for a handle, 0 for a null or released handle
+	unsigned int	GetTextureID(TextureHandle a_texture) const;
+
+	// Number of texture bytes that did not need decoding/uploading because the file contents matched an already loaded texture
+	unsigned long long GetBytesSaved() const { return m_bytesSaved; }
 
 private:
 
@@ -26,14 +49,29 @@ private:
 	// A small structure to reference count a texture
 	// references count indicates how many pointers are
 	// currently pointing to this texture -> only unload at @ refs
+	typedef std::pair<std::string, bool> PathKey;
 	typedef struct TextureRef
 	{
 	Texture* pTexure;
 	unsigned int refCount;
+	unsigned long long contentHash;
+	// Every filename that resolved to this texture, so releasing it doesn't have to search the path map
+	std::vector<PathKey> paths;
 	} TextureRef;
 	
-	std::map<std::string, TextureRef> m_pTextureMap;
-	
+	// Live textures, handles index straight into this table
+	SlotMap<TextureRef, TextureTag> m_textures;
+	// Textures are keyed on a hash of their file contents so byte-identical files
+	// stored under different names or directories share one GL texture
+	std::map<unsigned long long, TextureHandle> m_pTextureMap;
+	// Filename (and colour space) lookup into the texture table
+	std::map<PathKey, TextureHandle> m_pathMap;
+	unsigned long long m_bytesSaved;
+
+	TextureHandle FindTextureByPath(const char* a_filename, bool a_sRGB);
+	TextureHandle AddTexture(Texture* a_pTexture, unsigned long long a_contentHash, unsigned int a_refCount);
+	void AddPath(TextureHandle a_texture, const PathKey& a_path);
+
 	TextureManager();
 	~TextureManager();
-};
\ No newline at end of file
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// Hands slot indices between one producer and one consumer thread for triple buffered data
+// The producer always has a slot to write to and never waits, publishing swaps its slot with the ready one so the
+// consumer always picks up the newest complete frame. Frames the consumer didn't get to in time are simply replaced,
+// unless the producer chooses to wait for them to be taken first
+class TripleBuffer
+{
+public:
+	TripleBuffer() : m_writeSlot(0), m_readySlot(1), m_readSlot(2), m_hasNewFrame(false) {}
+
+	// Producer - the slot to fill in this frame
+	unsigned int GetWriteSlot() const { return m_writeSlot; }
+	// Producer - the write slot is complete, make it the ready slot and carry on writing into the old one
+	void Publish()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			unsigned int ready = m_readySlot;
+			m_readySlot = m_writeSlot;
+			m_writeSlot = ready;
+			m_hasNewFrame = true;
+		}
+		m_newFrame.notify_one();
+	}
+
+	// Consumer - wait up to a_timeout for a new frame then swap it in as the read slot, returns false on timeout
+	bool Acquire(std::chrono::milliseconds a_timeout)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (!m_newFrame.wait_for(lock, a_timeout, [this]() { return m_hasNewFrame; }))
+		{
+			return false;
+		}
+		unsigned int ready = m_readySlot;
+		m_readySlot = m_readSlot;
+		m_readSlot = ready;
+		m_hasNewFrame = false;
+		lock.unlock();
+		m_frameTaken.notify_one();
+		return true;
+	}
+	// Producer - wait up to a_timeout for the consumer to take the last published frame, returns false on timeout
+	// Waiting before each Publish means no frame gets replaced before the consumer has seen it
+	bool WaitUntilTaken(std::chrono::milliseconds a_timeout)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		return m_frameTaken.wait_for(lock, a_timeout, [this]() { return !m_hasNewFrame; });
+	}
+	// Consumer - the slot to read from after a successful Acquire
+	unsigned int GetReadSlot() const { return m_readSlot; }
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_newFrame;
+	std::condition_variable m_frameTaken;
+	unsigned int m_writeSlot;
+	unsigned int m_readySlot;
+	unsigned int m_readSlot;
+	bool m_hasNewFrame;
+};
@@ -4,6 +4,7 @@
 
 #include <glm/glm.hpp>
 
+struct GLFWwindow;
 
 class Utilities {
 
@@ -17,8 +18,12 @@ public:
 	// Helper function for loading shader code into memory
 	static char* fileToBuffer(const char* a_szPath);
 
-	//Utility for mouse / keyboard movement of matrix transform (suitable for camera)
-	static void		freeMovement(glm::mat4& a_transform,
+	// Fast non-cryptographic 64-bit hash (xxHash64) used to identify file contents
+	static unsigned long long hashBuffer(const void* a_data, size_t a_size, unsigned long long a_seed = 0);
+
+	//Utility for mouse / keyboard movement of matrix transform (suitable for camera), does nothing without a window
+	static void		freeMovement(GLFWwindow* a_window,
+		glm::mat4& a_transform,
 		float a_deltaTime,
 		float a_speed,
 		const glm::vec3& a_up = glm::vec3(0, 1, 0));
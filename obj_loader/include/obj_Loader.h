@@ -3,6 +3,77 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <string>
+#include <new>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+
+// Block allocator that owns everything a model loads (meshes, materials, names and vertex/index data)
+// Allocations are bumped out of large blocks and never freed individually, Release frees the lot in one go
+class OBJArena
+{
+public:
+	static constexpr size_t DefaultBlockSize = 256 * 1024;
+
+	OBJArena() : m_current(nullptr), m_offset(0), m_capacity(0), m_bytesUsed(0), m_bytesReserved(0) {}
+	~OBJArena() { Release(); }
+	OBJArena(const OBJArena&) = delete;
+	OBJArena& operator=(const OBJArena&) = delete;
+
+	void* Allocate(size_t a_size, size_t a_alignment = alignof(std::max_align_t));
+	// Construct a T in the arena, T must not need its destructor called
+	template<typename T>
+	T* Create() { return new (Allocate(sizeof(T), alignof(T))) T(); }
+	// Copy a_count elements into an arena array
+	template<typename T>
+	T* CopyArray(const T* a_data, size_t a_count)
+	{
+		if (a_count == 0) { return nullptr; }
+		T* array = static_cast<T*>(Allocate(sizeof(T) * a_count, alignof(T)));
+		std::uninitialized_copy(a_data, a_data + a_count, array);
+		return array;
+	}
+	// Copy a string into the arena, returns a null terminated copy
+	const char* CopyString(const std::string& a_string);
+	// Free every block
+	void Release();
+
+	// Bytes handed out and bytes held in blocks (the difference is padding and block tails)
+	size_t GetBytesUsed() const { return m_bytesUsed; }
+	size_t GetBytesReserved() const { return m_bytesReserved; }
+
+private:
+	std::vector<unsigned char*> m_blocks;
+	unsigned char* m_current;
+	size_t m_offset;
+	size_t m_capacity;
+	size_t m_bytesUsed;
+	size_t m_bytesReserved;
+};
+
+// Read only view of an array stored in a model's arena, has the bits of std::vector the renderer uses
+template<typename T>
+class OBJArray
+{
+public:
+	OBJArray() : m_data(nullptr), m_count(0) {}
+	OBJArray(T* a_data, size_t a_count) : m_data(a_data), m_count(a_count) {}
+
+	size_t size() const { return m_count; }
+	bool empty() const { return m_count == 0; }
+	T* data() { return m_data; }
+	const T* data() const { return m_data; }
+	T* begin() { return m_data; }
+	T* end() { return m_data + m_count; }
+	const T* begin() const { return m_data; }
+	const T* end() const { return m_data + m_count; }
+	T& operator[](size_t a_index) { return m_data[a_index]; }
+	const T& operator[](size_t a_index) const { return m_data[a_index]; }
+
+private:
+	T* m_data;
+	size_t m_count;
+};
 
 // A basic class for an OBJ file, supports vertex position, vertex normal, vertex uv Coord
 class OBJVertex
@@ -54,14 +125,14 @@ inline bool OBJVertex::operator < (const OBJVertex& a_rhs) const
 class OBJMaterial
 {
 public:
-	OBJMaterial() : name(), kA(0.f), kD(0.f), kS(0.f) {};
-	~OBJMaterial();
+	// Materials live in their model's arena so they have no destructor, strings are arena copies
+	OBJMaterial() : name(""), kA(0.f), kD(0.f), kS(0.f) {};
 
 	
 //************************************************************
 	// Getters and setters
-	const std::string Get_name() const { return name; };
-	void Set_name(std::string_view  set_name) { name = set_name; }
+	const char* Get_name() const { return name; };
+	void Set_name(const char* set_name) { name = set_name; }
 	
 	const glm::vec4& Get_kA() const { return kA; };
 	void Set_kA(const glm::vec4& set_kA) { kA = set_kA; }
@@ -84,12 +155,14 @@ public:
 
 		TextureTypes_Count
 	};
-	//texture will have filenames for loading, once loaded ID's stored in ID array
-	std::string textureFileNames[TextureTypes_Count];
-	unsigned int textureIDs[TextureTypes_Count];
+	//texture will have filenames for loading, once loaded ID's stored in ID array (empty string if there's no map)
+	const char* textureFileNames[TextureTypes_Count] = { "", "", "" };
+	unsigned int textureIDs[TextureTypes_Count]{};
+	// When textures are packed into texture arrays the IDs above are the array textures and this is the layer within each
+	unsigned int textureLayers[TextureTypes_Count]{};
 
 private:
-	std::string		name;
+	const char*		name;
 	// Colour and illumination variables 
 	glm::vec4		kA;		// Ambient light colour - alpha component stores Optical Density (Ni)(Refraction Index 0.001 - 10)
 	glm::vec4		kD;		// Diffuse light colour - alpha component stores dissolve (d)(0-1)
@@ -99,28 +172,25 @@ private:
 // An OBJ model can be composed of many meshes. Much like any 3D model
 // Lets use a class to store individual mesh data
 
+// Meshes live in their model's arena along with their name and vertex/index data
 class OBJMesh
 {
 public:
-	OBJMesh();
-	~OBJMesh();
+	OBJMesh() : m_name("") {}
 
 	glm::vec4 calculateFaceNormal(const unsigned int& a_indexA, const unsigned int& a_indexB, const unsigned int& a_indexC) const;
 	void calculateFaceNormals();
 
-	std::string					m_name;
-	std::vector<OBJVertex>		m_vertices;
-	std::vector<unsigned int>	m_indices;
+	const char*					m_name;
+	OBJArray<OBJVertex>			m_vertices;
+	OBJArray<unsigned int>		m_indices;
 	OBJMaterial*				m_material{};
 };
 
-inline OBJMesh::OBJMesh() {}
-inline OBJMesh::~OBJMesh() {};
-
 class OBJModel
 {
 public:
-	OBJModel() : m_worldMatrix(glm::mat4(1.f)), m_path(), m_meshes() {};
+	OBJModel() : m_meshes(), m_path(), m_worldMatrix(glm::mat4(1.f)) {};
 	~OBJModel()
 	{
 		unload();	//function to unload any data loaded in from file
@@ -133,6 +203,8 @@ public:
 	const char*			getPath()			const { return m_path.c_str(); }
 	unsigned int		getMeshCount()		const { return m_meshes.size(); }
 	unsigned int		getMaterialCount()	const { return m_materials.size(); }
+	// Bytes held by this model's arena
+	size_t				getMemoryUsage()	const { return m_arena.GetBytesReserved(); }
 	const glm::mat4&	getWorldMatrix()	const { return m_worldMatrix; }
 	// Functions to retrieve mesh by name or index for models that contain multiple meshes
 	OBJMesh*			getMeshByName(const char* a_name);
@@ -148,6 +220,8 @@ private:
 	std::vector<std::string> SplitStringAtCharacter(std::string data, char a_character);
 	void LoadMaterialLibrary(std::string a_mtllib);
 	std::pair<glm::vec4, glm::vec4> BoundingBox(const std::vector<glm::vec4>& vertexData);
+	// Copy the mesh being built into the arena and add it to the model
+	void FinishMesh(OBJMesh* a_mesh, std::vector<OBJVertex>& a_vertices, std::vector<unsigned int>& a_indices);
 
 	// OBJ face triplet struct;
 	typedef struct obj_face_triplet
@@ -168,4 +242,6 @@ private:
 	glm::mat4 m_worldMatrix;
 	// reading data from a current material pointer into OBJMaterial object
 	std::vector<OBJMaterial*> m_materials;
+	// Owns the meshes, materials and everything they point to
+	OBJArena m_arena;
 };
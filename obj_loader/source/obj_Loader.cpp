@@ -7,16 +7,84 @@
 #include <sstream>
 #include <algorithm>
 
-#include "obj_loader.h"
+#include "obj_Loader.h"
+
+#pragma region OBJArena
+void* OBJArena::Allocate(size_t a_size, size_t a_alignment)
+{
+	size_t aligned = (m_offset + a_alignment - 1) & ~(a_alignment - 1);
+	if (m_current == nullptr || aligned + a_size > m_capacity)
+	{
+		// Start a new block, anything bigger than a block (vertex data for big meshes) gets one to itself
+		size_t blockSize = a_size + a_alignment > DefaultBlockSize ? a_size + a_alignment : DefaultBlockSize;
+		unsigned char* block = static_cast<unsigned char*>(::operator new(blockSize));
+		m_blocks.push_back(block);
+		m_bytesReserved += blockSize;
+		m_current = block;
+		m_capacity = blockSize;
+		m_offset = 0;
+		// Blocks come back max_align_t aligned, over-aligned requests need padding from the block start
+		uintptr_t base = reinterpret_cast<uintptr_t>(block);
+		aligned = (size_t)(((base + a_alignment - 1) & ~(uintptr_t)(a_alignment - 1)) - base);
+	}
+	m_offset = aligned + a_size;
+	m_bytesUsed += a_size;
+	return m_current + aligned;
+}
+
+const char* OBJArena::CopyString(const std::string& a_string)
+{
+	char* copy = static_cast<char*>(Allocate(a_string.size() + 1, 1));
+	memcpy(copy, a_string.c_str(), a_string.size() + 1);
+	return copy;
+}
+
+void OBJArena::Release()
+{
+	for (unsigned char* block : m_blocks)
+	{
+		::operator delete(block);
+	}
+	m_blocks.clear();
+	m_current = nullptr;
+	m_offset = 0;
+	m_capacity = 0;
+	m_bytesUsed = 0;
+	m_bytesReserved = 0;
+}
+#pragma endregion OBJArena
+
+// Face normal of the triangle a, b, c
+static glm::vec4 FaceNormal(const glm::vec4& a_a, const glm::vec4& a_b, const glm::vec4& a_c)
+{
+	glm::vec3 ab = glm::normalize(glm::vec3(a_b) - glm::vec3(a_a));
+	glm::vec3 ac = glm::normalize(glm::vec3(a_c) - glm::vec3(a_a));
+	return glm::vec4(glm::cross(ab, ac), 0.f);
+}
 
 void OBJModel::unload()
 {
+	// Meshes and materials are all in the arena so there's nothing to delete one by one
 	m_meshes.clear();
+	m_materials.clear();
+	m_arena.Release();
+}
+
+void OBJModel::FinishMesh(OBJMesh* a_mesh, std::vector<OBJVertex>& a_vertices, std::vector<unsigned int>& a_indices)
+{
+	// Exact size copies into the arena, the builder vectors keep their capacity for the next mesh
+	a_mesh->m_vertices = OBJArray<OBJVertex>(m_arena.CopyArray(a_vertices.data(), a_vertices.size()), a_vertices.size());
+	a_mesh->m_indices = OBJArray<unsigned int>(m_arena.CopyArray(a_indices.data(), a_indices.size()), a_indices.size());
+	a_vertices.clear();
+	a_indices.clear();
+	m_meshes.push_back(a_mesh);
 }
 
 bool OBJModel::load(const char* a_filename, float a_scale)
 {
 	std::cout << "Attempting to open file: " << a_filename << std::endl;
+	// Loading over an existing model frees the old one first
+	unload();
 	// Get an fstream to read in the file data
 	std::fstream file;
 	file.open(a_filename, std::ios_base::in | std::ios_base::binary);
@@ -26,7 +94,7 @@ bool OBJModel::load(const char* a_filename, float a_scale)
 		std::cout << "Successfully opened" << std::endl;
 		//Get File path information 
 		std::string filePath = a_filename;
-		size_t path_end = filePath.find_last_of("\/\\");
+		size_t path_end = filePath.find_last_of("/\\");
 		if (path_end != std::string::npos)
 		{
 			filePath = filePath.substr(0, path_end + 1);
@@ -50,6 +118,9 @@ bool OBJModel::load(const char* a_filename, float a_scale)
 		std::cout << "File Size: " << fileSize / 1024 << " KB" << std::endl;
 
 		OBJMesh* currentMesh = nullptr;
+		// The mesh being read is built up here then copied into the arena when it's finished
+		std::vector<OBJVertex> meshVertices;
+		std::vector<unsigned int> meshIndices;
 		std::string fileLine;
 		std::vector<glm::vec4> vertexData;
 		std::vector<glm::vec4> normalData;
@@ -86,10 +157,10 @@ bool OBJModel::load(const char* a_filename, float a_scale)
 						// We can use group tags to split our model up into smaller mesh components
 						if (currentMesh != nullptr)
 						{
-							m_meshes.push_back(currentMesh);
+							FinishMesh(currentMesh, meshVertices, meshIndices);
 						}
-						currentMesh = new OBJMesh();
-						currentMesh->m_name = data;
+						currentMesh = m_arena.Create<OBJMesh>();
+						currentMesh->m_name = m_arena.CopyString(data);
 						if (currentMtl != nullptr) // If we have a material name
 						{
 							currentMesh->m_material = currentMtl;
@@ -122,7 +193,7 @@ bool OBJModel::load(const char* a_filename, float a_scale)
 					{
 						if (currentMesh == nullptr) // We have entered processing faces without having hit a 'o' or 'g' tag
 						{
-							currentMesh = new OBJMesh();
+							currentMesh = m_arena.Create<OBJMesh>();
 							if (currentMtl !=  nullptr)	// We have a marterial name
 							{
 								currentMesh->m_material = currentMtl;
@@ -132,7 +203,7 @@ bool OBJModel::load(const char* a_filename, float a_scale)
 						// Process face data
 						// Face consists of 3 -> more vertices split at ' ' then at '/' characters
 						std::vector<std::string> faceData = SplitStringAtCharacter(data, ' ');
-						unsigned int ci = currentMesh->m_vertices.size();
+						unsigned int ci = meshVertices.size();
 						for (auto iter = faceData.begin(); iter != faceData.end(); ++iter)
 						{
 							// Process face triplet
@@ -148,7 +219,7 @@ bool OBJModel::load(const char* a_filename, float a_scale)
 							{
 								currentVertex.uvcoord = UVData[triplet.vt - 1];
 							}
-							currentMesh->m_vertices.push_back(currentVertex);
+							meshVertices.push_back(currentVertex);
 						}
 						// All face information for the tri/quad/fan have been collected
 						// Time to index these into the current mesh
@@ -156,19 +227,19 @@ bool OBJModel::load(const char* a_filename, float a_scale)
 						bool calcNormals = normalData.empty();
 						for (unsigned int offset = 1; offset < (faceData.size() - 1); ++offset)
 						{
-							currentMesh->m_indices.push_back(ci);
-							currentMesh->m_indices.push_back(ci + offset);
-							currentMesh->m_indices.push_back(ci + 1 + offset);
+							meshIndices.push_back(ci);
+							meshIndices.push_back(ci + offset);
+							meshIndices.push_back(ci + 1 + offset);
 							// If we need to calculate normals we can do that here
 							if (calcNormals)
 							{
-								glm::vec4 normal = currentMesh->calculateFaceNormal(
-									ci,
-									ci + offset,
-									ci + offset + 1);
-								currentMesh->m_vertices[ci].normal = normal;
-								currentMesh->m_vertices[ci + offset].normal = normal;
-								currentMesh->m_vertices[ci + offset + 1].normal = normal;
+								glm::vec4 normal = FaceNormal(
+									meshVertices[ci].position,
+									meshVertices[ci + offset].position,
+									meshVertices[ci + offset + 1].position);
+								meshVertices[ci].normal = normal;
+								meshVertices[ci + offset].normal = normal;
+								meshVertices[ci + offset + 1].normal = normal;
 							}
 						}
 					}
@@ -193,8 +264,9 @@ bool OBJModel::load(const char* a_filename, float a_scale)
 
 		if (currentMesh != nullptr)
 		{
-			m_meshes.push_back(currentMesh);
+			FinishMesh(currentMesh, meshVertices, meshIndices);
 		}
+		std::cout << "Model memory: " << m_arena.GetBytesReserved() / 1024 << " KB" << std::endl;
 		file.close();
 		return true;
 	}
@@ -206,14 +278,7 @@ bool OBJModel::load(const char* a_filename, float a_scale)
 // Then performing the cross production function to get the surface normal of the face 
 glm::vec4 OBJMesh::calculateFaceNormal(const unsigned int& a_indexA, const unsigned int& a_indexB, const unsigned int& a_indexC) const
 {
-	glm::vec3 a = m_vertices[a_indexA].position;
-	glm::vec3 b = m_vertices[a_indexB].position;
-	glm::vec3 c = m_vertices[a_indexC].position;
-
-	glm::vec3 ab = glm::normalize(b - a);
-	glm::vec3 ac = glm::normalize(c - a);
-
-	return glm::vec4(glm::cross(ab, ac), 0.f);
+	return FaceNormal(m_vertices[a_indexA].position, m_vertices[a_indexB].position, m_vertices[a_indexC].position);
 }
 
 void OBJMesh::calculateFaceNormals()
@@ -295,8 +360,8 @@ void OBJModel::LoadMaterialLibrary(std::string a_mtllib)
 						{
 							m_materials.push_back(currentMaterial);
 						}
-						currentMaterial = new OBJMaterial();
-						currentMaterial->Set_name(data);
+						currentMaterial = m_arena.Create<OBJMaterial>();
+						currentMaterial->Set_name(m_arena.CopyString(data));
 						continue;
 					}
 					if (dataType == "Ns")	//Ns – this is a floating point value that is the specular power that we use in the calculation of the specular term in our fragment shader
@@ -389,7 +454,7 @@ void OBJModel::LoadMaterialLibrary(std::string a_mtllib)
 					{
 						std::vector<std::string> mapData = SplitStringAtCharacter(data, ' ');
 						currentMaterial->textureFileNames[OBJMaterial::TextureTypes::DiffuseTexture] =
-							m_path + mapData[mapData.size() - 1]; // We are only interested in the file name
+							m_arena.CopyString(m_path + mapData[mapData.size() - 1]); // We are only interested in the file name
 						//a nd other data is garbage as far as our loader is concerned
 						continue;
 					}
@@ -397,7 +462,7 @@ void OBJModel::LoadMaterialLibrary(std::string a_mtllib)
 					{
 						std::vector<std::string> mapData = SplitStringAtCharacter(data, ' ');
 						currentMaterial->textureFileNames[OBJMaterial::TextureTypes::SpecularTexture] =
-							m_path + mapData[mapData.size() - 1]; // We are only interested in the file name
+							m_arena.CopyString(m_path + mapData[mapData.size() - 1]); // We are only interested in the file name
 						//and other data is hot garbage as far as our loader is concerned
 						continue;
 					}
@@ -406,7 +471,7 @@ void OBJModel::LoadMaterialLibrary(std::string a_mtllib)
 					{
 						std::vector<std::string> mapData = SplitStringAtCharacter(data, ' ');
 						currentMaterial->textureFileNames[OBJMaterial::TextureTypes::NormalTexture] =
-							m_path + mapData[mapData.size() - 1]; // We are only interested in the file name
+							m_arena.CopyString(m_path + mapData[mapData.size() - 1]); // We are only interested in the file name
 						continue;
 					}
 				}
@@ -477,7 +542,7 @@ std::vector<std::string> OBJModel::SplitStringAtCharacter(std::string data, char
 
 OBJModel::obj_face_triplet OBJModel::ProcessTriplet(std::string a_triplet)
 {
-	std::vector<std::string> vertexIndices = SplitStringAtCharacter(a_triplet, '\/');
+	std::vector<std::string> vertexIndices = SplitStringAtCharacter(a_triplet, '/');
 	obj_face_triplet ft;
 	ft.v = 0; ft.vn = 0; ft.vt = 0;
 	ft.v = std::stoi(vertexIndices[0]);
@@ -509,8 +574,7 @@ OBJMaterial* OBJModel::getMaterialByName(const char* a_name)
 	for (auto iter = m_materials.begin(); iter != m_materials.end(); ++iter)
 	{
 		OBJMaterial* mat = (*iter);
-		std::string matName = mat->Get_name();
-		if(matName == a_name)
+		if(strcmp(mat->Get_name(), a_name) == 0)
 		{
 			return mat;
 		}
@@ -0,0 +1,40 @@
+//\------------------------------------------------------------------------------------------
+//\ Lighting = light parameters and the Blinn Phong terms shared by the obj fragment shader variants
+//\     Included through ShaderUtil's #include, the light values are uniforms so the application can move the light
+//\------------------------------------------------------------------------------------------
+
+uniform vec3 LightDirection = vec3(-10.0, -8.0, -10.0);
+uniform vec3 AmbientLight = vec3(0.1, 0.1, 0.1);	// iA
+uniform vec3 DiffuseLight = vec3(1.0, 1.0, 1.0);	// iD
+uniform vec3 SpecularLight = vec3(1.0, 1.0, 1.0);	// iS
+
+// Lambertian term
+float DiffuseTerm(vec3 a_normal, vec3 a_lightDir)
+{
+    return max(0.0, dot(a_normal, -a_lightDir));
+}
+
+// Phong specular term, a_power comes from the material's specular exponent
+float SpecularTerm(vec3 a_normal, vec3 a_lightDir, vec3 a_toEye, float a_power)
+{
+    vec3 R = reflect(a_lightDir, a_normal);     // reflected light vector
+    return pow(max(0.0, dot(a_toEye, R)), a_power);
+}
+
+#ifdef HAS_NORMAL_MAP
+// The vertex data has no tangents, so build the tangent frame from screen space derivatives of position and UV
+vec3 PerturbNormal(vec3 a_normal, vec3 a_position, vec2 a_uv, vec3 a_mapNormal)
+{
+    vec3 dp1 = dFdx(a_position);
+    vec3 dp2 = dFdy(a_position);
+    vec2 duv1 = dFdx(a_uv);
+    vec2 duv2 = dFdy(a_uv);
+    vec3 dp2perp = cross(dp2, a_normal);
+    vec3 dp1perp = cross(a_normal, dp1);
+    vec3 T = dp2perp * duv1.x + dp1perp * duv2.x;
+    vec3 B = dp2perp * duv1.y + dp1perp * duv2.y;
+    float invMax = inversesqrt(max(dot(T, T), dot(B, B)));
+    mat3 TBN = mat3(T * invMax, B * invMax, a_normal);
+    return normalize(TBN * (a_mapNormal * 2.0 - 1.0));
+}
+#endif
@@ -1,10 +1,16 @@
 //\------------------------------------------------------------------------------------------
 //\ Obj Fragment shader = Applying Blinn Phong lighting to our loaded OBJ Models
-//\     lightDir controlling the light direction  calculating the Dot Product between the origin of light and the models origin / direction 
+//\     Compiled as one variant per material feature mask, ShaderUtil injects the defines below after #version
+//\     USE_TEXTURE_ARRAYS - material textures are layers of texture arrays, TextureLayers selects the layer
+//\     HAS_DIFFUSE_MAP / HAS_SPECULAR_MAP / HAS_NORMAL_MAP - the material has that texture
+//\     HAS_SPECULAR - the material has a non zero kS, without it no specular work is done at all
+//\     ALPHA_TEST - the material has a dissolve below 1, fragments under half coverage are discarded
 //\------------------------------------------------------------------------------------------
 
 #version 400
 
+#include "lighting.glsl"
+
 smooth in vec4 vertPos;
 smooth in vec4 vertNormal;
 smooth in vec2 vertUV;
@@ -18,45 +24,64 @@ uniform vec4 kD;
 uniform vec4 kS;
 
 //uniforms for texture data
+#ifdef USE_TEXTURE_ARRAYS
+uniform sampler2DArray DiffuseTexture;
+uniform sampler2DArray SpecularTexture;
+uniform sampler2DArray NormalTexture;
+// x = diffuse layer, y = specular layer, z = normal layer
+uniform ivec3 TextureLayers;
+#define SAMPLE_MAP(a_sampler, a_layer) texture(a_sampler, vec3(vertUV, a_layer))
+#else
 uniform sampler2D DiffuseTexture;
 uniform sampler2D SpecularTexture;
 uniform sampler2D NormalTexture;
-
-vec3 iA = vec3(0.1f, 0.1f, 0.1f);
-vec3 iD = vec3(1.f, 1.f, 1.f);
-vec3 iS = vec3(1.f, 1.f, 1.f);
-
-vec4 lightDir = normalize(vec4(0.f) - vec4(10.f, 8.f, 10.f, 2.f)); 
+#define SAMPLE_MAP(a_sampler, a_layer) texture(a_sampler, vertUV)
+#endif
 
 uniform vec3 specularTint = vec3(1.0, 0.0, 0.0);
 
 void main()
 {
     // Get texture data from UV coords
-    float gamma = 2.2;
-   
-    vec4 diffuseTexData = texture(DiffuseTexture, vertUV);
-    vec3 DiffuseColour = pow( diffuseTexData.rgb, vec3(1.0/gamma));
-    //read specular texture
-    vec4 specularTexData = texture(SpecularTexture, vertUV);
-    vec3 SpecularColour = pow( specularTexData.rgb, vec3(1.0/gamma));
-    float specAlpha = specularTexData.a;
+    // Diffuse maps are stored as sRGB textures and specular maps as linear, so samples are already linear
+#ifdef HAS_DIFFUSE_MAP
+    vec4 diffuseTexData = SAMPLE_MAP(DiffuseTexture, TextureLayers.x);
+#else
+    vec4 diffuseTexData = vec4(1.0);
+#endif
+#ifdef ALPHA_TEST
+    // kD.a holds the material's dissolve
+    if (diffuseTexData.a * kD.a < 0.5) { discard; }
+#endif
+    vec3 DiffuseColour = diffuseTexData.rgb;
+
+    vec3 normal = normalize(vertNormal.xyz);
+#ifdef HAS_NORMAL_MAP
+    normal = PerturbNormal(normal, vertPos.xyz, vertUV, SAMPLE_MAP(NormalTexture, TextureLayers.z).rgb);
+#endif
+    vec3 lightDir = normalize(LightDirection);
+
+    vec3 Ambient = kA.xyz * AmbientLight; //ambient light
 
-    vec3 Ambient = kA.xyz * iA; //ambient light
-    
     // Get lambertian Term
-    float nDl = max(0.f, dot(normalize(vertNormal), -lightDir));
-    vec3 Diffuse = kD.xyz * iD * nDl * DiffuseColour;
+    vec3 Diffuse = kD.xyz * DiffuseLight * DiffuseTerm(normal, lightDir) * DiffuseColour;
+
+#ifdef HAS_SPECULAR
+#ifdef HAS_SPECULAR_MAP
+    //read specular texture
+    vec4 specularTexData = SAMPLE_MAP(SpecularTexture, TextureLayers.y);
+#else
+    vec4 specularTexData = vec4(1.0);
+#endif
+    vec3 SpecularColour = specularTexData.rgb;
+    float specAlpha = specularTexData.a;
 
-    vec3 R = reflect(lightDir, normalize(vertNormal)).xyz;  // reflected light vector
     vec3 E = normalize(camPos - vertPos).xyz;               // surface to eye vector
-    
-    
-    float specTerm = pow(max(0.f, dot(E, R)), kS.a);        // Specular Term
-    vec3 Specular = (kS.xyz * iS * specTerm * SpecularColour * specAlpha) * specularTint;
+    float specTerm = SpecularTerm(normal, lightDir, E, kS.a);        // Specular Term
+    vec3 Specular = (kS.xyz * SpecularLight * specTerm * SpecularColour * specAlpha) * specularTint;
+#else
+    vec3 Specular = vec3(0.0);
+#endif
 
     outputColour = vec4(Diffuse + Specular, 1.f);
 }
-
-
-
@@ -7,28 +7,415 @@
 
 #include "ShaderUtil.h"
 #include "Dispatcher.h"
+#include "JobSystem.h"
+#include "FrameAllocator.h"
+#include "MemoryStats.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "FrameStats.h"
+#include "RenderCounters.h"
+#include "GpuMemory.h"
+#include "HeadlessContext.h"
 
 // Include OpenGL Header
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
+#ifndef RENDER_FRAMEWORK_NO_GLFW
+#include <GLFW/glfw3.h>
 #include <imgui_impl_glfw.h>
+#endif
 
 // Include iostream for console logging
 #include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// ImGui's draw data points into buffers it reuses next frame, the render thread gets its own copy
+typedef struct ImGuiFrameSnapshot
+{
+    ImDrawData drawData;
+    ImVector<ImDrawList*> lists;
+    ~ImGuiFrameSnapshot()
+    {
+        for (ImDrawList* list : lists) { IM_DELETE(list); }
+    }
+} ImGuiFrameSnapshot;
+
+// The ImGui backend does its own GL calls, count them from the draw data it's about to submit
+// Each command list streams its vertices and indices into the backend's buffers, then one draw per command
+static void CountImGuiDrawData(const ImDrawData* a_drawData)
+{
+    if (!RenderCounters::IsEnabled() || a_drawData == nullptr) { return; }
+    for (int i = 0; i < a_drawData->CmdListsCount; ++i)
+    {
+        const ImDrawList* list = a_drawData->CmdLists[i];
+        RENDER_COUNT(BufferUploads, 2);
+        RENDER_COUNT(BufferBytesUploaded, list->VtxBuffer.Size * sizeof(ImDrawVert) + list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        RENDER_COUNT(DrawCalls, list->CmdBuffer.Size);
+        RENDER_COUNT(Triangles, list->IdxBuffer.Size / 3);
+    }
+}
+
+// Copy an ImVector's contents, keeping the destination's allocation when it's already big enough
+template<typename T>
+static void CopyImVector(ImVector<T>& a_dst, const ImVector<T>& a_src)
+{
+    a_dst.resize(a_src.Size);
+    if (a_src.Size > 0) { memcpy(a_dst.Data, a_src.Data, a_src.Size * sizeof(T)); }
+}
 
 bool Application::Create(const char* a_applicationName, unsigned int a_windowWidth, unsigned int a_windowHeight, bool a_fullscreen)
 {
-    //Initialise GLFW 
-    if (!glfwInit()) { return false; }
+    // Made first so load phases get recorded too
+    {
+        MemoryTagScope memoryTag(MemoryStats::Profiling);
+        CpuProfiler::CreateInstance()->SetThreadName("Main");
+    }
+    if (m_traceAfterFrames > 0)
+    {
+        CpuProfiler::GetInstance()->CaptureAfterFrames(m_traceAfterFrames);
+    }
 
     m_windowWidth = a_windowWidth;
     m_windowHeight = a_windowHeight;
 
+    {
+        // Whatever the driver allocates bringing the context up (Mesa and LLVM statics, EGL/GLX state) it keeps until exit
+        MemoryTagScope driverTag(MemoryStats::Driver);
+        if (m_headless)
+        {
+            // Windowless context rendering into an offscreen framebuffer, without one a hidden window does the same job
+            m_headlessContext = HeadlessContext::Create(m_windowWidth, m_windowHeight);
+        }
+        if (m_headlessContext != nullptr)
+        {
+            if (!gladLoadGLLoader((GLADloadproc)HeadlessContext::GetProcAddress) || !m_headlessContext->CreateFramebuffer())
+            {
+                delete m_headlessContext;
+                m_headlessContext = nullptr;
+                return false;
+            }
+            std::cout << "OpenGL Version " << glGetString(GL_VERSION) << " (" << glGetString(GL_RENDERER) << ")" << std::endl;
+        }
+        else if (!OpenWindow(a_applicationName, a_fullscreen))
+        {
+            return false;
+        }
+    }
+    // Only the driver and static initialisers have allocated so far, anything else still live at exit is a leak
+    MemoryStats::MarkBaseline();
+
+    // Create Disapatcher
+    Dispatcher::CreateInstance();
+    // Start the shared worker threads, subsystems submit jobs to this rather than making their own threads
+    JobSystem::CreateInstance();
+    // Scratch memory for each job system thread, reset every frame
+    FrameAllocator::CreateInstance(JobSystem::GetInstance()->GetThreadCount());
+    {
+        MemoryTagScope memoryTag(MemoryStats::Profiling);
+        // GPU timer queries, the query objects are made on the first frame by whichever thread draws
+        GpuProfiler::CreateInstance();
+        // Rolling CPU/GPU frame time percentiles, GPU times are fed in by the profiler as frames resolve
+        FrameStats::CreateInstance();
+        // Opt in, started before onCreate so the load phases get reported
+        if (m_telemetryEnabled)
+        {
+            Telemetry::CreateInstance(m_telemetryConfig);
+        }
+    }
+
+    // Set up IMGUI
+    IMGUI_CHECKVERSION();
+    // Route ImGui through the tracking so its allocations show up under UI
+    ImGui::SetAllocatorFunctions([](size_t a_size, void*) { return MemoryStats::Allocate(a_size, MemoryStats::UI); },
+        [](void* a_memory, void*) { MemoryStats::Free(a_memory); });
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO(); (void)io;
+    ImGui::StyleColorsDark();
+    const char* glsl_version = "#version 150";
+    InitImGuiPlatform();
+    ImGui_ImplOpenGL3_Init(glsl_version);
+
+    // Implement a call to the derived class onCreate function for any implementation specific code
+    bool result;
+    {
+        CPU_PROFILE_SCOPE("onCreate");
+        TelemetryLoadPhase loadPhase("onCreate");
+        std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+        result = onCreate();
+        m_loadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    }
+    // On failure the context and ImGui are left for Run to shut down along with everything else
+    return result;
+}
+
+bool Application::Run(const char* a_name, unsigned int a_width, unsigned int a_height, bool a_fullscreen)
+{
+    bool created = Create(a_name, a_width, a_height, a_fullscreen);
+    if (created)
+    {
+        Utilities::resetTimer();
+        m_running = true;
+        if (m_useRenderThread)
+        {
+            StartRenderThread();
+        }
+        m_presentedFrames = 0;
+        // Frames drawn here or handed to the render thread, the frame limit stops the loop once this reaches it
+        unsigned long long submittedFrames = 0;
+        std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+        do 
+        {
+            CPU_PROFILE_SCOPE("Frame");
+            float deltaTime = Utilities::tickTimer();
+            FrameStats::GetInstance()->RecordCpuFrame(deltaTime * 1000.f);
+
+            // Last frame's transient data is finished with, nothing should still be running jobs at this point
+            FrameAllocator::GetInstance()->Reset();
+            unsigned long long allocationCount = MemoryStats::GetAllocationCount();
+            m_lastFrameAllocations = allocationCount - m_frameStartAllocations;
+            m_frameStartAllocations = allocationCount;
+            for (int i = 0; i < MemoryStats::Tag_Count; ++i)
+            {
+                unsigned long long tagAllocations = MemoryStats::GetTagStats((MemoryStats::Tag)i).totalAllocations;
+                m_lastFrameTagAllocations[i] = tagAllocations - m_tagAllocationStart[i];
+                m_tagAllocationStart[i] = tagAllocations;
+            }
+
+            // Deliver the events queued during last frame's poll before anything uses them
+            if (Dispatcher* dp = Dispatcher::GetInstance())
+            {
+                CPU_PROFILE_SCOPE("Dispatch Events");
+                dp->FlushQueue();
+            }
+
+            // Start the Imgui frame, the GL backend only needs a new frame on the thread with the context
+            if (!m_useRenderThread)
+            {
+                ImGui_ImplOpenGL3_NewFrame();
+            }
+            NewImGuiPlatformFrame(deltaTime);
+            ImGui::NewFrame();
+            
+            {
+                MemoryTagScope memoryTag(MemoryStats::UI);
+                showFrameData(true);
+            }
+
+            {
+                CPU_PROFILE_SCOPE("Update");
+                Update(deltaTime);
+            }
+            {
+                CPU_PROFILE_SCOPE("ImGui::Render");
+                ImGui::Render();
+            }
+
+            if (m_useRenderThread)
+            {
+                // Hand the frame to the render thread and get straight on with the next one
+                CPU_PROFILE_SCOPE("Capture Frame");
+                unsigned int slot = m_frameHandoff.GetWriteSlot();
+                CaptureFrame(slot);
+                CaptureUI(slot);
+                if (m_frameLimit > 0)
+                {
+                    // Benchmarking, don't replace a frame the render thread hasn't taken yet so every frame made here is drawn
+                    CPU_PROFILE_SCOPE("Wait For Render Thread");
+                    while (!m_frameHandoff.WaitUntilTaken(std::chrono::milliseconds(16)) && m_renderThreadRunning) {}
+                }
+                m_frameHandoff.Publish();
+                ++submittedFrames;
+            }
+            else
+            {
+                CaptureFrame(0);
+                m_renderSlot = 0;
+                GpuProfiler* gpuProfiler = GpuProfiler::GetInstance();
+                gpuProfiler->BeginFrame();
+                {
+                    CPU_PROFILE_SCOPE("Draw");
+                    Draw();
+                }
+                {
+                    CPU_PROFILE_SCOPE("ImGui Draw");
+                    GpuProfileScope imguiScope("ImGui");
+                    CountImGuiDrawData(ImGui::GetDrawData());
+                    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+                }
+                gpuProfiler->EndFrame();
+                RenderCounters::EndFrame();
+
+                // Swap front and back buffers
+                CPU_PROFILE_SCOPE("SwapBuffers");
+                PresentFrame();
+                ++m_presentedFrames;
+                ++submittedFrames;
+            }
+            if (!PollWindow())
+            {
+                m_running = false;
+            }
+            CpuProfiler::GetInstance()->EndFrame();
+
+            if (Telemetry* telemetry = Telemetry::GetInstance())
+            {
+                FrameAllocator* frameAllocator = FrameAllocator::GetInstance();
+                TelemetryFrame frame = { deltaTime * 1000.f, m_lastFrameAllocations, MemoryStats::GetLiveBytes(), frameAllocator->GetLastFrameUsed() };
+                telemetry->RecordFrame(frame);
+            }
+            if (m_frameLimit > 0 && submittedFrames >= m_frameLimit)
+            {
+                m_running = false;
+            }
+        } while (m_running == true);
+        if (m_useRenderThread)
+        {
+            // Let the render thread present everything that was handed to it, so a frame limit draws exactly that many frames
+            // Only a benchmark waits for every frame to be taken, otherwise frames can be replaced and never presented
+            while (m_frameLimit > 0 && m_presentedFrames.load() < submittedFrames && m_renderThreadRunning)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            StopRenderThread();
+        }
+        if (m_frameLimit > 0)
+        {
+            PrintBenchmarkResults(m_presentedFrames.load(), std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count());
+        }
+        Destroy();
+    }
+   
+    delete[] m_uiSnapshots;
+    m_uiSnapshots = nullptr;
+
+    // Clean up IMGUI, Create may have failed before it was set up
+    if (ImGui::GetCurrentContext() != nullptr)
+    {
+        ImGui_ImplOpenGL3_Shutdown();
+        ShutdownImGuiPlatform();
+        ImGui::DestroyContext();
+    }
+
+    // Clean Up
+    ShaderUtil::DestroyInstance();
+    // Query objects have to go while the context is still around
+    GpuProfiler::DestroyInstance();
+    DestroyContext();
+    FrameAllocator::DestroyInstance();
+    JobSystem::DestroyInstance();
+    Dispatcher::DestroyInstance();
+    // Workers and the render thread have all finished so nothing can still be recording
+    CpuProfiler::DestroyInstance();
+    // Flushes whatever is still queued
+    Telemetry::DestroyInstance();
+    FrameStats::DestroyInstance();
+    return created;
+}
+
+#pragma region Render Thread
+void Application::StartRenderThread()
+{
+    m_uiSnapshots = new ImGuiFrameSnapshot[3];
+    // Let the GL backend create its font texture and shaders while the context is still current here
+    ImGui_ImplOpenGL3_NewFrame();
+    // Release the context so the render thread can take it
+    MakeContextCurrent(false);
+    m_renderThreadRunning = true;
+    m_renderThread = std::thread(&Application::RenderThreadLoop, this);
+    std::cout << "Rendering on a dedicated render thread" << std::endl;
+}
+
+void Application::StopRenderThread()
+{
+    m_renderThreadRunning = false;
+    if (m_renderThread.joinable())
+    {
+        m_renderThread.join();
+    }
+    // Take the context back for Destroy and shutdown
+    MakeContextCurrent(true);
+}
+
+void Application::RenderThreadLoop()
+{
+    MakeContextCurrent(true);
+    CpuProfiler::GetInstance()->SetThreadName("Render");
+    while (m_renderThreadRunning)
+    {
+        // Time out now and then so we notice when we're asked to stop
+        if (!m_frameHandoff.Acquire(std::chrono::milliseconds(16)))
+        {
+            continue;
+        }
+        CPU_PROFILE_SCOPE("Render Frame");
+        m_renderSlot = m_frameHandoff.GetReadSlot();
+        GpuProfiler* gpuProfiler = GpuProfiler::GetInstance();
+        gpuProfiler->BeginFrame();
+        {
+            CPU_PROFILE_SCOPE("Draw");
+            Draw();
+        }
+        {
+            CPU_PROFILE_SCOPE("ImGui Draw");
+            GpuProfileScope imguiScope("ImGui");
+            CountImGuiDrawData(&m_uiSnapshots[m_renderSlot].drawData);
+            ImGui_ImplOpenGL3_RenderDrawData(&m_uiSnapshots[m_renderSlot].drawData);
+        }
+        gpuProfiler->EndFrame();
+        RenderCounters::EndFrame();
+        CPU_PROFILE_SCOPE("SwapBuffers");
+        PresentFrame();
+        ++m_presentedFrames;
+    }
+    MakeContextCurrent(false);
+}
+
+void Application::CaptureUI(unsigned int a_slot)
+{
+    ImGuiFrameSnapshot& snapshot = m_uiSnapshots[a_slot];
+    ImDrawData* source = ImGui::GetDrawData();
+    // Draw lists are kept between frames so after the first few frames copying doesn't allocate
+    while (snapshot.lists.Size < source->CmdListsCount)
+    {
+        snapshot.lists.push_back(IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData()));
+    }
+    for (int i = 0; i < source->CmdListsCount; ++i)
+    {
+        ImDrawList* dst = snapshot.lists[i];
+        const ImDrawList* src = source->CmdLists[i];
+        CopyImVector(dst->CmdBuffer, src->CmdBuffer);
+        CopyImVector(dst->IdxBuffer, src->IdxBuffer);
+        CopyImVector(dst->VtxBuffer, src->VtxBuffer);
+        dst->Flags = src->Flags;
+    }
+    snapshot.drawData = *source;
+    snapshot.drawData.CmdLists = snapshot.lists.Data;
+}
+#pragma endregion Render Thread
+
+#pragma region Context
+// The GL context is either a GLFW window's or a headless one, these keep the rest of Application from caring which
+// Every GLFW call lives here, builds without GLFW (RENDER_FRAMEWORK_NO_GLFW) can only run headless
+bool Application::OpenWindow(const char* a_applicationName, bool a_fullscreen)
+{
+#ifdef RENDER_FRAMEWORK_NO_GLFW
+    (void)a_applicationName; (void)a_fullscreen;
+    std::cout << "Built without GLFW, only headless rendering is available" << std::endl;
+    return false;
+#else
+    //Initialise GLFW 
+    if (!glfwInit()) { return false; }
+
+    // Request an sRGB capable default framebuffer so shaders can output linear colour
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, m_headless ? GLFW_FALSE : GLFW_TRUE);
     //create a windowed mode window and it's OpenGL context 
     m_window = glfwCreateWindow(m_windowWidth, m_windowHeight, a_applicationName,
-        (a_fullscreen ? glfwGetPrimaryMonitor() : nullptr), nullptr);
+        (a_fullscreen && !m_headless ? glfwGetPrimaryMonitor() : nullptr), nullptr);
 
     if (!m_window)
     {
@@ -42,6 +429,7 @@ bool Application::Create(const char* a_applicationName, unsigned int a_windowWid
     // Initialise GLAD - Load in GL Extensions
     if (!gladLoadGL()) {
         glfwDestroyWindow(m_window);
+        m_window = nullptr;
         glfwTerminate();
         return false;
     }
@@ -55,78 +443,134 @@ bool Application::Create(const char* a_applicationName, unsigned int a_windowWid
     // Set up glfw window resize callback function
     glfwSetWindowSizeCallback(m_window, [](GLFWwindow*, int w, int h)
     {
-        // Call the global dispatcher to handle this function
+        // Queue the resize with the global dispatcher, resizes coalesce so a drag only costs one rebuild per frame
         Dispatcher* dp = Dispatcher::GetInstance();
         if (dp != nullptr)
         {
-            dp->Publish(new WindowResizeEvent(w, h), true);
+            dp->Enqueue(WindowResizeEvent(w, h));
         }
     });
+    return true;
+#endif
+}
 
-    // Create Disapatcher
-    Dispatcher::CreateInstance();
+bool Application::PollWindow()
+{
+#ifndef RENDER_FRAMEWORK_NO_GLFW
+    if (m_window != nullptr)
+    {
+        // Poll for and process events
+        {
+            CPU_PROFILE_SCOPE("PollEvents");
+            glfwPollEvents();
+        }
+        // F9 writes a trace of the last few seconds of CPU zones
+        bool captureKey = glfwGetKey(m_window, GLFW_KEY_F9) == GLFW_PRESS;
+        if (captureKey && !m_captureKeyDown)
+        {
+            CpuProfiler::GetInstance()->RequestCapture();
+        }
+        m_captureKeyDown = captureKey;
+        return glfwWindowShouldClose(m_window) == 0;
+    }
+#endif
+    return true;
+}
 
-    // Set up IMGUI
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO(); (void)io;
-    ImGui::StyleColorsDark();
-    const char* glsl_version = "#version 150";
-    ImGui_ImplGlfw_InitForOpenGL(m_window, true);
-    ImGui_ImplOpenGL3_Init(glsl_version);
+void Application::InitImGuiPlatform()
+{
+#ifndef RENDER_FRAMEWORK_NO_GLFW
+    if (m_window != nullptr)
+    {
+        ImGui_ImplGlfw_InitForOpenGL(m_window, true);
+        return;
+    }
+#endif
+    // No platform backend headless, ImGui still runs so its cost is part of the frame
+    ImGui::GetIO().DisplaySize = ImVec2((float)m_windowWidth, (float)m_windowHeight);
+}
 
-    // Implement a call to the derived class onCreate function for any implementation specific code
-    bool result = onCreate();
-    if (result == false)
+void Application::NewImGuiPlatformFrame(float a_deltaTime)
+{
+#ifndef RENDER_FRAMEWORK_NO_GLFW
+    if (m_window != nullptr)
     {
-        // Cleaning up any of the GLFW Implementation code and end the application loop
-        glfwDestroyWindow(m_window);
-        glfwTerminate();
+        ImGui_ImplGlfw_NewFrame();
+        return;
     }
-    return result;
+#endif
+    ImGui::GetIO().DeltaTime = (a_deltaTime > 0.f) ? a_deltaTime : 1.f / 1000.f;
 }
 
-void Application::Run(const char* a_name, unsigned int a_width, unsigned int a_height, bool a_fullscreen)
+void Application::ShutdownImGuiPlatform()
 {
-    if (Create(a_name, a_width, a_height, a_fullscreen))
+#ifndef RENDER_FRAMEWORK_NO_GLFW
+    if (m_window != nullptr)
     {
-        Utilities::resetTimer();
-        m_running = true;
-        do 
-        {
-            float deltaTime = Utilities::tickTimer();
+        ImGui_ImplGlfw_Shutdown();
+    }
+#endif
+}
 
-            // Start the Imgui frame
-            ImGui_ImplOpenGL3_NewFrame();
-            ImGui_ImplGlfw_NewFrame();
-            ImGui::NewFrame();
-            
-            showFrameData(true);
+void Application::MakeContextCurrent(bool a_current)
+{
+    if (m_headlessContext != nullptr)
+    {
+        if (a_current) { m_headlessContext->MakeCurrent(); }
+        else { m_headlessContext->ReleaseCurrent(); }
+        return;
+    }
+#ifndef RENDER_FRAMEWORK_NO_GLFW
+    glfwMakeContextCurrent(a_current ? m_window : nullptr);
+#endif
+}
 
-            Update(deltaTime);
-            Draw();
-            ImGui::Render();
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+void Application::PresentFrame()
+{
+    if (m_headlessContext != nullptr)
+    {
+        m_headlessContext->Present();
+        return;
+    }
+#ifndef RENDER_FRAMEWORK_NO_GLFW
+    glfwSwapBuffers(m_window);
+#endif
+}
 
-            // Swap front and back buffers
-            glfwSwapBuffers(m_window); 
-            // Poll for and process events
-            glfwPollEvents();
-        } while (m_running == true && glfwWindowShouldClose(m_window) == 0);
-        Destroy();
+void Application::DestroyContext()
+{
+    if (m_headlessContext != nullptr)
+    {
+        delete m_headlessContext;
+        m_headlessContext = nullptr;
+        return;
     }
-   
-    // Clean up IMGUI
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+#ifndef RENDER_FRAMEWORK_NO_GLFW
+    if (m_window != nullptr)
+    {
+        glfwDestroyWindow(m_window);
+        m_window = nullptr;
+        glfwTerminate();
+    }
+#endif
+}
 
-    // Clean Up
-    ShaderUtil::DestroyInstance();
-    glfwDestroyWindow(m_window);
-    glfwTerminate();
-    Dispatcher::DestroyInstance();
+void Application::PrintBenchmarkResults(unsigned long long a_frames, double a_seconds)
+{
+    // Percentiles cover the most recent FrameTimeSeries::Capacity frames, GPU times lag a few frames behind
+    FrameStats::Summary cpu = FrameStats::GetInstance()->GetSummary(FrameStats::CpuFrame);
+    FrameStats::Summary gpu = FrameStats::GetInstance()->GetSummary(FrameStats::GpuFrame);
+    printf("Benchmark results (%ux%u%s)\n", m_windowWidth, m_windowHeight, (m_headlessContext != nullptr) ? ", headless" : "");
+    printf("  load          %10.2f ms\n", m_loadMs);
+    printf("  frames        %10llu in %.3f s (%.1f fps)\n", a_frames, a_seconds, (a_seconds > 0.0) ? a_frames / a_seconds : 0.0);
+    printf("  cpu frame ms  avg %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f  (%llu hitches)\n",
+        cpu.average, cpu.p50, cpu.p95, cpu.p99, cpu.max, cpu.totalHitches);
+    printf("  gpu frame ms  avg %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n", gpu.average, gpu.p50, gpu.p95, gpu.p99, gpu.max);
+    printf("  heap          %10.1f KB live, %.1f KB peak\n", MemoryStats::GetLiveBytes() / 1024.f, MemoryStats::GetPeakBytes() / 1024.f);
+    printf("  gpu memory    %10.1f MB, %.1f MB peak\n", GpuMemory::GetTotalBytes() / (1024.f * 1024.f), GpuMemory::GetPeakBytes() / (1024.f * 1024.f));
+    fflush(stdout);
 }
+#pragma endregion Context
 
 void Application::showFrameData(bool a_bShowFrameData)
 {
@@ -145,6 +589,67 @@ void Application::showFrameData(bool a_bShowFrameData)
     {
         ImGui::Separator();
         ImGui::Text("Application Average: %.3f ms/frame (%.1f FPS)", 1000.f / io.Framerate, io.Framerate);
+        // Tail frame times matter more than the average, see the Frame Statistics window for the full picture
+        if (FrameStats* frameStats = FrameStats::GetInstance())
+        {
+            FrameStats::Summary cpu = frameStats->GetSummary(FrameStats::CpuFrame);
+            FrameStats::Summary gpu = frameStats->GetSummary(FrameStats::GpuFrame);
+            ImGui::Text("CPU p50/p95/p99: %.2f / %.2f / %.2f ms (%u hitches)", cpu.p50, cpu.p95, cpu.p99, cpu.hitches);
+            ImGui::Text("GPU p50/p95/p99: %.2f / %.2f / %.2f ms", gpu.p50, gpu.p95, gpu.p99);
+        }
+        // Steady state frames should make no heap allocations, transient data belongs in the frame allocator
+        ImGui::Text("Heap allocations last frame: %llu", m_lastFrameAllocations);
+        ImGui::Text("Heap: %.1f KB live, %.1f KB peak", MemoryStats::GetLiveBytes() / 1024.f, MemoryStats::GetPeakBytes() / 1024.f);
+        // Which subsystem the memory belongs to, and who is still allocating every frame
+        ImGui::Text("Subsystem     live KB   peak KB  allocs");
+        for (int i = 0; i < MemoryStats::Tag_Count; ++i)
+        {
+            MemoryStats::TagStats tagStats = MemoryStats::GetTagStats((MemoryStats::Tag)i);
+            if (tagStats.peakBytes == 0) { continue; }
+            ImGui::Text("%-10s %10.1f %9.1f %7llu", MemoryStats::GetTagName((MemoryStats::Tag)i), tagStats.liveBytes / 1024.f,
+                tagStats.peakBytes / 1024.f, m_lastFrameTagAllocations[i]);
+        }
+        if (FrameAllocator* frameAllocator = FrameAllocator::GetInstance())
+        {
+            ImGui::Text("Frame arena: %.1f / %.1f KB (%llu overflows)", frameAllocator->GetLastFrameUsed() / 1024.f,
+                frameAllocator->GetCapacity() / 1024.f, frameAllocator->GetOverflowCount());
+        }
+        // GPU memory by category, see the Frame Statistics window for the individual allocations
+        {
+            size_t gpuBytes[GpuMemory::Category_Count];
+            GpuMemory::GetCategoryBytes(gpuBytes);
+            size_t gpuBudget = GpuMemory::GetBudget();
+            ImGui::Separator();
+            if (gpuBudget > 0)
+            {
+                ImGui::Text("GPU memory: %.1f / %.1f MB", GpuMemory::GetTotalBytes() / (1024.f * 1024.f), gpuBudget / (1024.f * 1024.f));
+            }
+            else
+            {
+                ImGui::Text("GPU memory: %.1f MB", GpuMemory::GetTotalBytes() / (1024.f * 1024.f));
+            }
+            if (GpuMemory::IsOverBudget())
+            {
+                ImGui::SameLine();
+                ImGui::TextColored(ImVec4(1.f, 0.3f, 0.3f, 1.f), "OVER BUDGET");
+            }
+            for (int i = 0; i < GpuMemory::Category_Count; ++i)
+            {
+                if (gpuBytes[i] == 0) { continue; }
+                ImGui::Text("  %-14s %9.1f KB", GpuMemory::GetCategoryName((GpuMemory::Category)i), gpuBytes[i] / 1024.f);
+            }
+        }
+        // What last frame's Draw and the UI asked GL to do
+        if (RenderCounters::IsEnabled())
+        {
+            unsigned long long counters[RenderCounters::Counter_Count];
+            RenderCounters::GetLastFrame(counters);
+            ImGui::Separator();
+            ImGui::Text("Draws %llu, tris %llu, programs %llu, textures %llu", counters[RenderCounters::DrawCalls], counters[RenderCounters::Triangles],
+                counters[RenderCounters::ProgramBinds], counters[RenderCounters::TextureBinds]);
+            ImGui::Text("Buffer uploads %llu (%.1f KB), state changes %llu", counters[RenderCounters::BufferUploads],
+                counters[RenderCounters::BufferBytesUploaded] / 1024.f, counters[RenderCounters::StateChanges]);
+        }
         if (ImGui::IsMousePosValid())
         {
             ImGui::Text("MousePosition: (%.1f, %.1f)", io.MousePos.x, io.MousePos.y);
@@ -153,6 +658,23 @@ void Application::showFrameData(bool a_bShowFrameData)
         {
             ImGui::Text("Mouse Position: <Invalid>");
         }
+        // GPU time per scope, indented by nesting. Results are a few frames old as they're read back without stalling
+        if (GpuProfiler* gpuProfiler = GpuProfiler::GetInstance())
+        {
+            gpuProfiler->GetStats(m_gpuStats);
+            ImGui::Separator();
+            ImGui::Text("GPU (ms)          avg     max");
+            for (const GpuProfiler::ScopeStats& stats : m_gpuStats)
+            {
+                int indent = (int)stats.depth * 2;
+                int nameWidth = (indent < 14) ? 14 - indent : 0;
+                ImGui::Text("%*s%-*s %7.3f %7.3f", indent, "", nameWidth, stats.name, stats.averageMs, stats.maxMs);
+            }
+            if (gpuProfiler->GetDroppedFrames() > 0)
+            {
+                ImGui::Text("Frames not ready in time: %llu", gpuProfiler->GetDroppedFrames());
+            }
+        }
     }
     ImGui::End();
 }
@@ -0,0 +1,116 @@
+#include "Benchmarks.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "ApplicationEvent.h"
+#include "EventChannel.h"
+#include "JobSystem.h"
+
+// Delivery callback for the channel benchmark, just counts what arrives
+static void CountEvent(void* a_counter, Event*)
+{
+	++*static_cast<unsigned long long*>(a_counter);
+}
+
+void Benchmarks::EventChannelThroughput(unsigned int a_eventsPerRun)
+{
+	unsigned int maxProducers = std::thread::hardware_concurrency();
+	if (maxProducers < 2) { maxProducers = 2; }
+	std::cout << "EventChannel benchmark: " << a_eventsPerRun << " events per run" << std::endl;
+
+	// Double the producer count each run to show how the ring holds up under contention
+	for (unsigned int producers = 1; producers <= maxProducers; producers *= 2)
+	{
+		EventChannel channel(4096);
+		unsigned int perProducer = a_eventsPerRun / producers;
+		unsigned long long expected = (unsigned long long)perProducer * producers;
+		unsigned long long received = 0;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		std::vector<std::thread> threads;
+		for (unsigned int p = 0; p < producers; ++p)
+		{
+			threads.emplace_back([&channel, perProducer, p]()
+			{
+				WindowResizeEvent e(p, 0);
+				for (unsigned int i = 0; i < perProducer; ++i)
+				{
+					channel.Post(e, &CountEvent);
+				}
+			});
+		}
+		// This thread plays the main thread and drains until everything has arrived
+		while (received < expected)
+		{
+			if (channel.Drain(&received) == 0) { std::this_thread::yield(); }
+		}
+		for (std::thread& t : threads) { t.join(); }
+		double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		EventChannelStats stats = channel.GetStats();
+		std::cout << "  " << producers << " producer(s): " << (expected / seconds) / 1000000.0 << " M events/s, "
+			<< stats.stalls << " stalls, peak depth " << stats.peakDepth << "/" << channel.GetCapacity() << std::endl;
+	}
+}
+
+void Benchmarks::JobSystemScaling(unsigned int a_elementCount)
+{
+	unsigned int cores = std::thread::hardware_concurrency();
+	if (cores == 0) { cores = 1; }
+	std::cout << "JobSystem benchmark: " << a_elementCount << " elements, up to " << cores << " thread(s)" << std::endl;
+
+	// 1, 2, 4... threads and finally every core if that isn't a power of two
+	std::vector<unsigned int> threadCounts;
+	for (unsigned int threads = 1; threads < cores; threads *= 2) { threadCounts.push_back(threads); }
+	threadCounts.push_back(cores);
+
+	std::vector<float> data(a_elementCount);
+	double baseline[2] = { 0.0, 0.0 };
+	for (unsigned int threads : threadCounts)
+	{
+		double seconds[2] = { 0.0, 0.0 };
+		unsigned long long steals = 0;
+		// Run on a fresh thread so it can own its own job system without touching the global one
+		std::thread runner([&]()
+		{
+			JobSystem jobs(threads - 1);
+
+			// Coarse data parallel work
+			auto start = std::chrono::high_resolution_clock::now();
+			float* values = data.data();
+			jobs.ParallelFor(a_elementCount, 4096, [values](size_t a_begin, size_t a_end)
+			{
+				for (size_t i = a_begin; i < a_end; ++i)
+				{
+					values[i] = std::sqrt((float)i) * std::sin((float)i);
+				}
+			});
+			seconds[0] = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+			// Lots of tiny jobs to measure scheduling overhead, submitted in batches so the job ring never wraps
+			std::atomic<unsigned int> ran(0);
+			start = std::chrono::high_resolution_clock::now();
+			for (unsigned int batch = 0; batch < 256; ++batch)
+			{
+				JobCounter counter;
+				for (unsigned int i = 0; i < 1024; ++i)
+				{
+					jobs.Run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }, &counter);
+				}
+				jobs.Wait(&counter);
+			}
+			seconds[1] = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+			steals = jobs.GetStealCount();
+		});
+		runner.join();
+
+		if (threads == 1) { baseline[0] = seconds[0]; baseline[1] = seconds[1]; }
+		std::cout << "  " << threads << " thread(s): parallel_for " << seconds[0] * 1000.0 << "ms (x" << baseline[0] / seconds[0]
+			<< "), 262144 empty jobs " << seconds[1] * 1000.0 << "ms (x" << baseline[1] / seconds[1] << "), " << steals << " steals" << std::endl;
+	}
+}
@@ -0,0 +1,76 @@
+#include "BufferManager.h"
+#include "GpuMemory.h"
+
+#include <glad/glad.h>
+#include <iostream>
+
+// Set up a static pointer for Singleton object
+BufferManager* BufferManager::m_instance = nullptr;
+
+BufferManager* BufferManager::CreateInstance()
+{
+	if (nullptr == m_instance)
+	{
+		m_instance = new BufferManager();
+	}
+	return m_instance;
+}
+
+BufferManager* BufferManager::GetInstance()
+{
+	if (nullptr == m_instance)
+	{
+		return BufferManager::CreateInstance();
+	}
+	return m_instance;
+}
+
+void BufferManager::DestroyInstance()
+{
+	if (nullptr != m_instance)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+BufferManager::BufferManager() : m_buffers()
+{
+}
+
+BufferManager::~BufferManager()
+{
+	// Free anything that was never destroyed, the names are packed so this is a single GL call
+	if (!m_buffers.Empty())
+	{
+		std::cout << "Deleting " << m_buffers.Size() << " buffers that were not destroyed" << std::endl;
+		for (unsigned int buffer : m_buffers)
+		{
+			GpuMemory::ReleaseBuffer(buffer);
+		}
+		glDeleteBuffers((GLsizei)m_buffers.Size(), &*m_buffers.begin());
+	}
+}
+
+BufferHandle BufferManager::CreateBuffer()
+{
+	unsigned int buffer = 0;
+	glGenBuffers(1, &buffer);
+	return m_buffers.Insert(buffer);
+}
+
+void BufferManager::DestroyBuffer(BufferHandle a_buffer)
+{
+	if (unsigned int* buffer = m_buffers.Get(a_buffer))
+	{
+		GpuMemory::ReleaseBuffer(*buffer);
+		glDeleteBuffers(1, buffer);
+		m_buffers.Remove(a_buffer);
+	}
+}
+
+unsigned int BufferManager::GetBufferID(BufferHandle a_buffer) const
+{
+	const unsigned int* buffer = m_buffers.Get(a_buffer);
+	return (buffer != nullptr) ? *buffer : 0;
+}
@@ -0,0 +1,218 @@
+#include "CpuProfiler.h"
+#include "MemoryStats.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+CpuProfiler* CpuProfiler::m_instance = nullptr;
+std::atomic<unsigned int> CpuProfiler::m_instanceCount(0);
+
+// The ring this thread records into and which profiler instance it was made for
+static thread_local void* tls_ring = nullptr;
+static thread_local unsigned int tls_ringOwner = 0;
+
+// Gives the thread's ring back to the profiler when the thread exits
+struct ThreadRingRelease
+{
+	bool active = false;
+	~ThreadRingRelease()
+	{
+		CpuProfiler* profiler = CpuProfiler::GetInstance();
+		if (active && tls_ring != nullptr && profiler != nullptr && tls_ringOwner == profiler->m_instanceID)
+		{
+			profiler->ReleaseThreadRing(static_cast<CpuProfiler::ThreadRing*>(tls_ring));
+		}
+		tls_ring = nullptr;
+	}
+};
+static thread_local ThreadRingRelease tls_ringRelease;
+
+CpuProfiler* CpuProfiler::CreateInstance()
+{
+	if (m_instance == nullptr)
+	{
+		m_instance = new CpuProfiler();
+	}
+	return m_instance;
+}
+
+void CpuProfiler::DestroyInstance()
+{
+	if (m_instance)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+CpuProfiler::CpuProfiler() :
+	m_enabled(true), m_captureRequested(false), m_framesUntilCapture(0), m_captureCount(0),
+	m_instanceID(++m_instanceCount), m_startTime(Now())
+{
+}
+
+CpuProfiler::~CpuProfiler()
+{
+	// Every thread that recorded has been joined by now, apart from the main thread whose cached ring just goes stale
+	for (ThreadRing* ring : m_rings)
+	{
+		delete ring;
+	}
+	m_rings.clear();
+	m_freeRings.clear();
+}
+
+CpuProfiler::ThreadRing* CpuProfiler::GetThreadRing()
+{
+	if (tls_ring != nullptr && tls_ringOwner == m_instanceID)
+	{
+		return static_cast<ThreadRing*>(tls_ring);
+	}
+	// First zone on this thread, the only time recording takes the lock
+	MemoryTagScope memoryTag(MemoryStats::Profiling);
+	ThreadRing* ring = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_ringMutex);
+		if (!m_freeRings.empty())
+		{
+			// Take over a finished thread's ring, its lane in the trace carries on with this thread's zones
+			ring = m_freeRings.back();
+			m_freeRings.pop_back();
+			ring->name = "Thread " + std::to_string(ring->threadID);
+		}
+	}
+	if (ring == nullptr)
+	{
+		ring = new ThreadRing();
+		ring->writeIndex.store(0);
+		std::lock_guard<std::mutex> lock(m_ringMutex);
+		ring->threadID = (unsigned int)m_rings.size();
+		ring->name = "Thread " + std::to_string(ring->threadID);
+		m_rings.push_back(ring);
+	}
+	tls_ring = ring;
+	tls_ringOwner = m_instanceID;
+	tls_ringRelease.active = true;
+	return ring;
+}
+
+void CpuProfiler::ReleaseThreadRing(ThreadRing* a_ring)
+{
+	MemoryTagScope memoryTag(MemoryStats::Profiling);
+	std::lock_guard<std::mutex> lock(m_ringMutex);
+	m_freeRings.push_back(a_ring);
+}
+
+void CpuProfiler::SetThreadName(const char* a_name)
+{
+	ThreadRing* ring = GetThreadRing();
+	std::lock_guard<std::mutex> lock(m_ringMutex);
+	ring->name = a_name;
+}
+
+void CpuProfiler::RecordZone(const char* a_name, Timestamp a_start, Timestamp a_end)
+{
+	ThreadRing* ring = GetThreadRing();
+	unsigned long long index = ring->writeIndex.load(std::memory_order_relaxed);
+	RingZone& zone = ring->zones[index & (ZonesPerThread - 1)];
+	zone.name.store(a_name, std::memory_order_relaxed);
+	zone.start.store(a_start, std::memory_order_relaxed);
+	zone.end.store(a_end, std::memory_order_relaxed);
+	ring->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void CpuProfiler::EndFrame()
+{
+	bool capture = m_captureRequested.exchange(false);
+	if (m_framesUntilCapture > 0 && --m_framesUntilCapture == 0)
+	{
+		capture = true;
+	}
+	if (capture)
+	{
+		WriteTrace();
+	}
+}
+
+// Names are code literals so only quotes and backslashes need escaping
+static void WriteJsonString(std::ofstream& a_file, const char* a_string)
+{
+	a_file << '"';
+	for (const char* c = a_string; *c != '\0'; ++c)
+	{
+		if (*c == '"' || *c == '\\') { a_file << '\\'; }
+		a_file << *c;
+	}
+	a_file << '"';
+}
+
+void CpuProfiler::WriteTrace()
+{
+	typedef struct CapturedZone
+	{
+		Zone zone;
+		unsigned int threadID;
+	} CapturedZone;
+	std::vector<CapturedZone> captured;
+	std::vector<std::pair<unsigned int, std::string>> threadNames;
+	{
+		std::lock_guard<std::mutex> lock(m_ringMutex);
+		for (ThreadRing* ring : m_rings)
+		{
+			threadNames.emplace_back(ring->threadID, ring->name);
+			unsigned long long end = ring->writeIndex.load(std::memory_order_acquire);
+			unsigned long long begin = (end > ZonesPerThread) ? end - ZonesPerThread : 0;
+			size_t firstCopied = captured.size();
+			for (unsigned long long i = begin; i < end; ++i)
+			{
+				const RingZone& zone = ring->zones[i & (ZonesPerThread - 1)];
+				captured.push_back(CapturedZone{ { zone.name.load(std::memory_order_relaxed), zone.start.load(std::memory_order_relaxed),
+					zone.end.load(std::memory_order_relaxed) }, ring->threadID });
+			}
+			// The owner kept recording while we copied, anything it has since lapped (including the slot
+			// it may be half way through writing) could be torn so drop it
+			std::atomic_thread_fence(std::memory_order_acquire);
+			unsigned long long after = ring->writeIndex.load(std::memory_order_acquire);
+			unsigned long long firstValid = (after + 1 > ZonesPerThread) ? after + 1 - ZonesPerThread : 0;
+			if (firstValid > begin)
+			{
+				size_t discard = (size_t)((firstValid < end ? firstValid : end) - begin);
+				captured.erase(captured.begin() + firstCopied, captured.begin() + firstCopied + discard);
+			}
+		}
+	}
+
+	std::string filename = "cpu_trace_" + std::to_string(m_captureCount++) + ".json";
+	std::ofstream file(filename);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to write CPU trace: " << filename << std::endl;
+		return;
+	}
+	// Trace timestamps are in microseconds
+	const double ticksToMicroseconds = 1000000.0 * std::chrono::steady_clock::period::num / std::chrono::steady_clock::period::den;
+	file << "{\"traceEvents\":[\n";
+	bool first = true;
+	for (const std::pair<unsigned int, std::string>& thread : threadNames)
+	{
+		file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.first << ",\"args\":{\"name\":";
+		WriteJsonString(file, thread.second.c_str());
+		file << "}}";
+		first = false;
+	}
+	file.precision(3);
+	file << std::fixed;
+	for (const CapturedZone& captureZone : captured)
+	{
+		const Zone& zone = captureZone.zone;
+		file << (first ? "" : ",\n") << "{\"name\":";
+		WriteJsonString(file, zone.name);
+		file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << captureZone.threadID
+			<< ",\"ts\":" << (zone.start - m_startTime) * ticksToMicroseconds
+			<< ",\"dur\":" << (zone.end - zone.start) * ticksToMicroseconds << "}";
+		first = false;
+	}
+	file << "\n]}\n";
+	std::cout << "Wrote " << captured.size() << " CPU zones to " << filename << std::endl;
+}
@@ -1,4 +1,19 @@
 #include "Dispatcher.h"
 
 // Static instance initialised to nullptr - So we dont initialise it in the header
-Dispatcher* Dispatcher::m_instance = nullptr;
\ No newline at end of file
+Dispatcher* Dispatcher::m_instance = nullptr;
+
+void Dispatcher::FlushQueue()
+{
+	// Hand over anything worker threads posted, they're published straight away in the order they arrived
+	m_channel.Drain(this);
+
+	// Swap buffers first so anything queued by a handler waits for the next flush instead of looping forever
+	EventQueue& queue = m_queues[m_writeQueue];
+	m_writeQueue ^= 1;
+	for (QueuedEvent& queued : queue.events)
+	{
+		queued.publish(this, queued.event);
+	}
+	ClearQueue(queue);
+}
@@ -0,0 +1,105 @@
+#include "EventChannel.h"
+
+#include <thread>
+
+EventChannel::EventChannel(size_t a_capacity) :
+	m_slots(nullptr), m_mask(0), m_enqueuePos(0), m_dequeuePos(0), m_peakDepth(0), m_rejected(0), m_stalls(0)
+{
+	// Round up to a power of two so wrapping is a mask rather than a divide
+	size_t capacity = 2;
+	while (capacity < a_capacity) { capacity <<= 1; }
+	m_mask = capacity - 1;
+	m_slots = new Slot[capacity];
+	for (size_t i = 0; i < capacity; ++i)
+	{
+		// A slot is free for the producer at position i when its sequence equals i
+		m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		m_slots[i].event = nullptr;
+	}
+}
+
+EventChannel::~EventChannel()
+{
+	// Destroy anything that was posted but never drained
+	while (GetDepth() > 0)
+	{
+		Slot& slot = m_slots[m_dequeuePos & m_mask];
+		if (slot.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1) { break; }
+		slot.event->~Event();
+		++m_dequeuePos;
+	}
+	delete[] m_slots;
+}
+
+EventChannel::Slot* EventChannel::ClaimSlot()
+{
+	size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		Slot* slot = &m_slots[pos & m_mask];
+		size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+		if (diff == 0)
+		{
+			// Slot is free for this position, race the other producers for it
+			if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				slot->claimed = pos;
+				return slot;
+			}
+		}
+		else if (diff < 0)
+		{
+			// The consumer hasn't freed this slot from the last lap yet, we're full
+			return nullptr;
+		}
+		else
+		{
+			// Another producer got here first, reload and try the next position
+			pos = m_enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void EventChannel::Backoff()
+{
+	std::this_thread::yield();
+}
+
+size_t EventChannel::Drain(void* a_context, size_t a_maxEvents)
+{
+	size_t depth = GetDepth();
+	if (depth > m_peakDepth) { m_peakDepth = depth; }
+
+	size_t delivered = 0;
+	while (delivered < a_maxEvents)
+	{
+		Slot& slot = m_slots[m_dequeuePos & m_mask];
+		// A slot is ready once its producer has stored position + 1
+		if (slot.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1) { break; }
+		slot.deliver(a_context, slot.event);
+		slot.event->~Event();
+		slot.event = nullptr;
+		// Free the slot for the producer one lap ahead
+		slot.sequence.store(m_dequeuePos + m_mask + 1, std::memory_order_release);
+		++m_dequeuePos;
+		++delivered;
+	}
+	return delivered;
+}
+
+size_t EventChannel::GetDepth() const
+{
+	return m_enqueuePos.load(std::memory_order_relaxed) - m_dequeuePos;
+}
+
+EventChannelStats EventChannel::GetStats() const
+{
+	EventChannelStats stats;
+	stats.posted = m_enqueuePos.load(std::memory_order_relaxed);
+	stats.drained = m_dequeuePos;
+	stats.rejected = m_rejected.load(std::memory_order_relaxed);
+	stats.stalls = m_stalls.load(std::memory_order_relaxed);
+	stats.peakDepth = m_peakDepth;
+	return stats;
+}
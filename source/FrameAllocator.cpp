@@ -0,0 +1,145 @@
+#include "FrameAllocator.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "JobSystem.h"
+
+// Static instance initialised to nullptr
+FrameAllocator* FrameAllocator::m_instance = nullptr;
+
+#pragma region LinearArena
+// Callers can't do anything useful with a null frame allocation, so fail loudly here rather than crash somewhere later
+static void* ArenaMalloc(size_t a_size)
+{
+	void* memory = malloc(a_size);
+	if (memory == nullptr)
+	{
+		std::cout << "Frame allocator: out of memory allocating " << a_size << " bytes" << std::endl;
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+LinearArena::LinearArena(size_t a_capacity) :
+	m_memory(nullptr), m_capacity(a_capacity), m_offset(0), m_used(0), m_lastFrameUsed(0), m_peak(0), m_overflowCount(0),
+	m_overflow(nullptr)
+{
+	m_memory = static_cast<unsigned char*>(ArenaMalloc(m_capacity));
+}
+
+LinearArena::~LinearArena()
+{
+	Reset();
+	free(m_memory);
+}
+
+void* LinearArena::Allocate(size_t a_size, size_t a_alignment)
+{
+	m_used += a_size;
+	if (m_used > m_peak) { m_peak = m_used; }
+
+	uintptr_t base = reinterpret_cast<uintptr_t>(m_memory);
+	uintptr_t aligned = (base + m_offset + a_alignment - 1) & ~(uintptr_t)(a_alignment - 1);
+	size_t end = (size_t)(aligned - base) + a_size;
+	if (end <= m_capacity)
+	{
+		m_offset = end;
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	// Doesn't fit, fall back to the heap until Reset grows the block
+	++m_overflowCount;
+	size_t alignment = a_alignment < alignof(std::max_align_t) ? alignof(std::max_align_t) : a_alignment;
+	OverflowBlock* block = static_cast<OverflowBlock*>(ArenaMalloc(sizeof(OverflowBlock) + a_size + alignment));
+	block->next = m_overflow;
+	m_overflow = block;
+	uintptr_t overflowAligned = (reinterpret_cast<uintptr_t>(block + 1) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	return reinterpret_cast<void*>(overflowAligned);
+}
+
+void LinearArena::Reset()
+{
+	if (m_overflow != nullptr)
+	{
+		while (m_overflow != nullptr)
+		{
+			OverflowBlock* next = m_overflow->next;
+			free(m_overflow);
+			m_overflow = next;
+		}
+		// Grow so the biggest frame so far fits in the block, with some slack for alignment padding
+		size_t capacity = m_capacity;
+		while (capacity < m_peak + m_peak / 4) { capacity *= 2; }
+		free(m_memory);
+		m_memory = static_cast<unsigned char*>(ArenaMalloc(capacity));
+		m_capacity = capacity;
+	}
+	m_offset = 0;
+	m_lastFrameUsed = m_used;
+	m_used = 0;
+}
+#pragma endregion LinearArena
+
+FrameAllocator::FrameAllocator(unsigned int a_threadCount, size_t a_bytesPerThread) :
+	m_sharedArena(a_bytesPerThread)
+{
+	for (unsigned int i = 0; i < a_threadCount; ++i)
+	{
+		m_threadArenas.push_back(new LinearArena(a_bytesPerThread));
+	}
+}
+
+FrameAllocator::~FrameAllocator()
+{
+	for (LinearArena* arena : m_threadArenas)
+	{
+		delete arena;
+	}
+}
+
+void* FrameAllocator::Allocate(size_t a_size, size_t a_alignment)
+{
+	JobSystem* jobs = JobSystem::GetInstance();
+	int index = jobs ? jobs->GetThreadIndex() : -1;
+	if (index >= 0 && index < (int)m_threadArenas.size())
+	{
+		// Only this thread ever touches its arena so no locking needed
+		return m_threadArenas[index]->Allocate(a_size, a_alignment);
+	}
+	std::lock_guard<std::mutex> lock(m_sharedMutex);
+	return m_sharedArena.Allocate(a_size, a_alignment);
+}
+
+void FrameAllocator::Reset()
+{
+	for (LinearArena* arena : m_threadArenas)
+	{
+		arena->Reset();
+	}
+	std::lock_guard<std::mutex> lock(m_sharedMutex);
+	m_sharedArena.Reset();
+}
+
+size_t FrameAllocator::GetLastFrameUsed() const
+{
+	size_t used = m_sharedArena.GetLastFrameUsed();
+	for (const LinearArena* arena : m_threadArenas) { used += arena->GetLastFrameUsed(); }
+	return used;
+}
+
+size_t FrameAllocator::GetCapacity() const
+{
+	size_t capacity = m_sharedArena.GetCapacity();
+	for (const LinearArena* arena : m_threadArenas) { capacity += arena->GetCapacity(); }
+	return capacity;
+}
+
+unsigned long long FrameAllocator::GetOverflowCount() const
+{
+	unsigned long long count = m_sharedArena.GetOverflowCount();
+	for (const LinearArena* arena : m_threadArenas) { count += arena->GetOverflowCount(); }
+	return count;
+}
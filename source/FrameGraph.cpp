@@ -0,0 +1,139 @@
+#include "FrameGraph.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "JobSystem.h"
+
+unsigned int FrameGraph::AddTask(const char* a_name, TaskFunction a_function,
+	std::initializer_list<Resource> a_reads, std::initializer_list<Resource> a_writes, bool a_mainThread)
+{
+	Task task;
+	task.name = a_name;
+	task.function = std::move(a_function);
+	task.reads.assign(a_reads.begin(), a_reads.end());
+	task.writes.assign(a_writes.begin(), a_writes.end());
+	task.mainThread = a_mainThread;
+	task.predecessorCount = 0;
+	m_tasks.push_back(std::move(task));
+	m_compiled = false;
+	return (unsigned int)m_tasks.size() - 1;
+}
+
+// True if any resource appears in both lists
+static bool Overlaps(const std::vector<FrameGraph::Resource>& a_lhs, const std::vector<FrameGraph::Resource>& a_rhs)
+{
+	for (FrameGraph::Resource resource : a_lhs)
+	{
+		if (std::find(a_rhs.begin(), a_rhs.end(), resource) != a_rhs.end()) { return true; }
+	}
+	return false;
+}
+
+void FrameGraph::Compile()
+{
+	for (Task& task : m_tasks)
+	{
+		task.successors.clear();
+		task.predecessorCount = 0;
+	}
+	// Tasks were added in single threaded order so only earlier tasks can be dependencies
+	for (unsigned int later = 0; later < m_tasks.size(); ++later)
+	{
+		Task& task = m_tasks[later];
+		for (unsigned int earlier = 0; earlier < later; ++earlier)
+		{
+			Task& previous = m_tasks[earlier];
+			// Read after write, write after write and write after read all need ordering
+			if (Overlaps(previous.writes, task.reads) || Overlaps(previous.writes, task.writes) || Overlaps(previous.reads, task.writes))
+			{
+				previous.successors.push_back(later);
+				++task.predecessorCount;
+			}
+		}
+	}
+	m_pending = std::vector<std::atomic<unsigned int>>(m_tasks.size());
+	m_mainThreadReady.clear();
+	m_mainThreadReady.reserve(m_tasks.size());
+	m_compiled = true;
+}
+
+void FrameGraph::Execute(JobSystem* a_jobs)
+{
+	if (!m_compiled) { Compile(); }
+	if (m_tasks.empty()) { return; }
+
+	if (a_jobs == nullptr)
+	{
+		// No workers, the order tasks were added in is always a valid order to run them
+		for (Task& task : m_tasks) { task.function(); }
+		return;
+	}
+
+	m_jobs = a_jobs;
+	m_remaining.store((unsigned int)m_tasks.size());
+	for (unsigned int i = 0; i < m_tasks.size(); ++i)
+	{
+		m_pending[i].store(m_tasks[i].predecessorCount, std::memory_order_relaxed);
+	}
+	for (unsigned int i = 0; i < m_tasks.size(); ++i)
+	{
+		if (m_tasks[i].predecessorCount == 0) { Launch(i); }
+	}
+
+	// Run main thread tasks as they become ready and help the workers out in between
+	while (m_remaining.load(std::memory_order_acquire) > 0)
+	{
+		unsigned int ready = (unsigned int)-1;
+		{
+			std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+			if (!m_mainThreadReady.empty())
+			{
+				ready = m_mainThreadReady.back();
+				m_mainThreadReady.pop_back();
+			}
+		}
+		if (ready != (unsigned int)-1)
+		{
+			RunTask(ready);
+		}
+		else if (!m_jobs->ExecutePendingJob())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void FrameGraph::Clear()
+{
+	m_tasks.clear();
+	m_pending.clear();
+	m_compiled = false;
+}
+
+void FrameGraph::Launch(unsigned int a_index)
+{
+	if (m_tasks[a_index].mainThread)
+	{
+		std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+		m_mainThreadReady.push_back(a_index);
+		return;
+	}
+	FrameGraph* graph = this;
+	m_jobs->Run([graph, a_index]() { graph->RunTask(a_index); });
+}
+
+void FrameGraph::RunTask(unsigned int a_index)
+{
+	Task& task = m_tasks[a_index];
+	task.function();
+	for (unsigned int successor : task.successors)
+	{
+		// The last predecessor to finish launches the successor
+		if (m_pending[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			Launch(successor);
+		}
+	}
+	m_remaining.fetch_sub(1, std::memory_order_release);
+}
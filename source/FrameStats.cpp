@@ -0,0 +1,221 @@
+#include "FrameStats.h"
+
+#include <cstring>
+
+#pragma region FrameTimeSeries
+FrameTimeSeries::FrameTimeSeries() : m_hitchThresholdMs(1000.f / 60.f * 2.f), m_totalHitches(0)
+{
+	Clear();
+}
+
+void FrameTimeSeries::Clear()
+{
+	memset(m_samples, 0, sizeof(m_samples));
+	memset(m_histogram, 0, sizeof(m_histogram));
+	m_maxFront = 0;
+	m_maxSize = 0;
+	m_sequence = 0;
+	m_count = 0;
+	m_sum = 0.0;
+	m_windowHitches = 0;
+}
+
+unsigned int FrameTimeSeries::BucketFor(float a_ms)
+{
+	if (a_ms <= 0.f) { return 0; }
+	unsigned int bucket = (unsigned int)(a_ms / BucketWidthMs);
+	return (bucket < BucketCount) ? bucket : BucketCount - 1;
+}
+
+void FrameTimeSeries::AddSample(float a_ms)
+{
+	unsigned int slot = (unsigned int)(m_sequence % Capacity);
+	// Take the sample about to be overwritten out of everything first
+	if (m_count == Capacity)
+	{
+		float evicted = m_samples[slot];
+		--m_histogram[BucketFor(evicted)];
+		m_sum -= evicted;
+		if (evicted > m_hitchThresholdMs) { --m_windowHitches; }
+		if (m_maxSize > 0 && m_maxQueue[m_maxFront] == m_sequence - Capacity)
+		{
+			m_maxFront = (m_maxFront + 1) % Capacity;
+			--m_maxSize;
+		}
+	}
+	else
+	{
+		++m_count;
+	}
+
+	m_samples[slot] = a_ms;
+	++m_histogram[BucketFor(a_ms)];
+	m_sum += a_ms;
+	if (a_ms > m_hitchThresholdMs)
+	{
+		++m_windowHitches;
+		++m_totalHitches;
+	}
+	// Anything at the back no bigger than the new sample can never be the max again
+	while (m_maxSize > 0)
+	{
+		unsigned long long back = m_maxQueue[(m_maxFront + m_maxSize - 1) % Capacity];
+		if (m_samples[back % Capacity] > a_ms) { break; }
+		--m_maxSize;
+	}
+	m_maxQueue[(m_maxFront + m_maxSize) % Capacity] = m_sequence;
+	++m_maxSize;
+	++m_sequence;
+}
+
+float FrameTimeSeries::GetPercentile(float a_percentile) const
+{
+	if (m_count == 0) { return 0.f; }
+	// Rank of the sample we're after, 1 based so p100 is the last sample
+	unsigned int rank = (unsigned int)(a_percentile / 100.f * m_count + 0.5f);
+	if (rank < 1) { rank = 1; }
+	if (rank > m_count) { rank = m_count; }
+	unsigned int seen = 0;
+	for (unsigned int bucket = 0; bucket < BucketCount; ++bucket)
+	{
+		seen += m_histogram[bucket];
+		if (seen >= rank)
+		{
+			// Overflow bucket has no top, the max is the best we know
+			if (bucket == BucketCount - 1) { return GetMax(); }
+			float top = (bucket + 1) * BucketWidthMs;
+			float maximum = GetMax();
+			return (top < maximum) ? top : maximum;
+		}
+	}
+	return GetMax();
+}
+
+float FrameTimeSeries::GetMax() const
+{
+	if (m_maxSize == 0) { return 0.f; }
+	return m_samples[m_maxQueue[m_maxFront] % Capacity];
+}
+
+float FrameTimeSeries::GetAverage() const
+{
+	return (m_count > 0) ? (float)(m_sum / m_count) : 0.f;
+}
+
+float FrameTimeSeries::GetLatest() const
+{
+	return (m_count > 0) ? m_samples[(m_sequence - 1) % Capacity] : 0.f;
+}
+
+void FrameTimeSeries::SetHitchThreshold(float a_ms)
+{
+	m_hitchThresholdMs = a_ms;
+	// Only happens when the budget changes, so a rescan is fine
+	m_windowHitches = 0;
+	for (unsigned long long i = m_sequence - m_count; i < m_sequence; ++i)
+	{
+		if (m_samples[i % Capacity] > m_hitchThresholdMs) { ++m_windowHitches; }
+	}
+}
+
+void FrameTimeSeries::CopySamples(std::vector<float>& a_samples) const
+{
+	a_samples.resize(m_count);
+	for (unsigned int i = 0; i < m_count; ++i)
+	{
+		a_samples[i] = m_samples[(m_sequence - m_count + i) % Capacity];
+	}
+}
+
+void FrameTimeSeries::CopyHistogram(std::vector<float>& a_bins, float a_binWidthMs, float a_maxMs) const
+{
+	unsigned int binCount = (unsigned int)(a_maxMs / a_binWidthMs + 0.5f);
+	if (binCount == 0) { binCount = 1; }
+	a_bins.assign(binCount, 0.f);
+	for (unsigned int bucket = 0; bucket < BucketCount; ++bucket)
+	{
+		if (m_histogram[bucket] == 0) { continue; }
+		// Anything past the end piles up in the last bin so slow frames stay visible
+		unsigned int bin = (unsigned int)(bucket * BucketWidthMs / a_binWidthMs);
+		a_bins[(bin < binCount) ? bin : binCount - 1] += (float)m_histogram[bucket];
+	}
+}
+#pragma endregion FrameTimeSeries
+
+#pragma region FrameStats
+FrameStats* FrameStats::m_instance = nullptr;
+
+FrameStats* FrameStats::CreateInstance()
+{
+	if (m_instance == nullptr)
+	{
+		m_instance = new FrameStats();
+	}
+	return m_instance;
+}
+
+void FrameStats::DestroyInstance()
+{
+	if (m_instance)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+FrameStats::FrameStats() : m_budgetMs(0.f)
+{
+	SetBudget(1000.f / 60.f);
+}
+
+void FrameStats::Record(Series a_series, float a_ms)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_series[a_series].AddSample(a_ms);
+}
+
+FrameStats::Summary FrameStats::GetSummary(Series a_series) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const FrameTimeSeries& series = m_series[a_series];
+	Summary summary;
+	summary.p50 = series.GetPercentile(50.f);
+	summary.p95 = series.GetPercentile(95.f);
+	summary.p99 = series.GetPercentile(99.f);
+	summary.max = series.GetMax();
+	summary.average = series.GetAverage();
+	summary.latest = series.GetLatest();
+	summary.count = series.GetCount();
+	summary.hitches = series.GetHitchCount();
+	summary.totalHitches = series.GetTotalHitches();
+	return summary;
+}
+
+float FrameStats::GetPercentile(Series a_series, float a_percentile) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_series[a_series].GetPercentile(a_percentile);
+}
+
+void FrameStats::CopySamples(Series a_series, std::vector<float>& a_samples) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_series[a_series].CopySamples(a_samples);
+}
+
+void FrameStats::CopyHistogram(Series a_series, std::vector<float>& a_bins, float a_binWidthMs, float a_maxMs) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_series[a_series].CopyHistogram(a_bins, a_binWidthMs, a_maxMs);
+}
+
+void FrameStats::SetBudget(float a_ms)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_budgetMs = a_ms;
+	for (FrameTimeSeries& series : m_series)
+	{
+		series.SetHitchThreshold(a_ms * HitchFactor);
+	}
+}
+#pragma endregion FrameStats
@@ -0,0 +1,206 @@
+#include "GpuMemory.h"
+#include "MemoryStats.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+// Buffer, texture and renderbuffer names are separate namespaces in GL, the upper bits say which one a key is from
+static const unsigned long long s_textureKey = 1ull << 32;
+static const unsigned long long s_renderbufferKey = 2ull << 32;
+
+static std::mutex s_mutex;
+static std::unordered_map<unsigned long long, GpuMemory::Allocation> s_allocations;
+static size_t s_categoryBytes[GpuMemory::Category_Count] = {};
+static size_t s_totalBytes = 0;
+static size_t s_peakBytes = 0;
+static size_t s_budget = 0;
+static bool s_overBudget = false;
+
+static const char* s_categoryNames[GpuMemory::Category_Count] = { "Vertex buffers", "Index buffers", "Textures", "Texture arrays", "Cubemaps", "Render targets" };
+
+// Called with the lock held whenever the total goes up
+static void CheckBudget()
+{
+	if (s_totalBytes > s_peakBytes) { s_peakBytes = s_totalBytes; }
+	bool overBudget = s_budget > 0 && s_totalBytes > s_budget;
+	if (overBudget && !s_overBudget)
+	{
+		std::cout << "GPU memory over budget: " << s_totalBytes / (1024 * 1024) << " MB of " << s_budget / (1024 * 1024) << " MB" << std::endl;
+	}
+	s_overBudget = overBudget;
+}
+
+static void Record(unsigned long long a_key, unsigned int a_name, GpuMemory::Category a_category, unsigned int a_format, size_t a_bytes, const char* a_owner)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	auto it = s_allocations.find(a_key);
+	if (it == s_allocations.end())
+	{
+		// The registry is only grown when a new GL object appears, re-specifying an existing one doesn't allocate
+		MemoryTagScope memoryTag(MemoryStats::Profiling);
+		it = s_allocations.emplace(a_key, GpuMemory::Allocation{ a_name, a_category, a_format, 0, (a_owner != nullptr) ? a_owner : "" }).first;
+	}
+	GpuMemory::Allocation& allocation = it->second;
+	s_categoryBytes[allocation.category] -= allocation.bytes;
+	s_totalBytes -= allocation.bytes;
+	allocation.category = a_category;
+	allocation.format = a_format;
+	allocation.bytes = a_bytes;
+	s_categoryBytes[a_category] += a_bytes;
+	s_totalBytes += a_bytes;
+	CheckBudget();
+}
+
+static void Release(unsigned long long a_key)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	auto it = s_allocations.find(a_key);
+	if (it == s_allocations.end()) { return; }
+	s_categoryBytes[it->second.category] -= it->second.bytes;
+	s_totalBytes -= it->second.bytes;
+	s_allocations.erase(it);
+	if (s_allocations.empty())
+	{
+		// Hand the buckets back too so an orderly shutdown leaves nothing allocated
+		std::unordered_map<unsigned long long, GpuMemory::Allocation>().swap(s_allocations);
+	}
+	if (s_overBudget && s_totalBytes <= s_budget) { s_overBudget = false; }
+}
+
+void GpuMemory::RecordBuffer(unsigned int a_buffer, Category a_category, size_t a_bytes, const char* a_owner)
+{
+	if (a_buffer == 0) { return; }
+	Record(a_buffer, a_buffer, a_category, 0, a_bytes, a_owner);
+}
+
+void GpuMemory::ReleaseBuffer(unsigned int a_buffer)
+{
+	Release(a_buffer);
+}
+
+void GpuMemory::RecordTexture(unsigned int a_texture, Category a_category, unsigned int a_format, unsigned int a_width, unsigned int a_height,
+	unsigned int a_layers, unsigned int a_mipLevels, const char* a_owner)
+{
+	if (a_texture == 0) { return; }
+	Record(s_textureKey | a_texture, a_texture, a_category, a_format, TextureBytes(a_format, a_width, a_height, a_layers, a_mipLevels), a_owner);
+}
+
+void GpuMemory::ReleaseTexture(unsigned int a_texture)
+{
+	Release(s_textureKey | a_texture);
+}
+
+void GpuMemory::RecordRenderbuffer(unsigned int a_renderbuffer, unsigned int a_format, unsigned int a_width, unsigned int a_height, const char* a_owner)
+{
+	if (a_renderbuffer == 0) { return; }
+	Record(s_renderbufferKey | a_renderbuffer, a_renderbuffer, RenderTargets, a_format, TextureBytes(a_format, a_width, a_height, 1, 1), a_owner);
+}
+
+void GpuMemory::ReleaseRenderbuffer(unsigned int a_renderbuffer)
+{
+	Release(s_renderbufferKey | a_renderbuffer);
+}
+
+size_t GpuMemory::GetTotalBytes()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	return s_totalBytes;
+}
+
+size_t GpuMemory::GetPeakBytes()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	return s_peakBytes;
+}
+
+void GpuMemory::GetCategoryBytes(size_t (&a_bytes)[Category_Count])
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	std::copy(s_categoryBytes, s_categoryBytes + Category_Count, a_bytes);
+}
+
+void GpuMemory::CopyAllocations(std::vector<Allocation>& a_allocations)
+{
+	a_allocations.clear();
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		a_allocations.reserve(s_allocations.size());
+		for (const auto& entry : s_allocations)
+		{
+			a_allocations.push_back(entry.second);
+		}
+	}
+	std::sort(a_allocations.begin(), a_allocations.end(), [](const Allocation& a_lhs, const Allocation& a_rhs) { return a_lhs.bytes > a_rhs.bytes; });
+}
+
+void GpuMemory::SetBudget(size_t a_bytes)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_budget = a_bytes;
+	s_overBudget = false;
+	CheckBudget();
+}
+
+size_t GpuMemory::GetBudget()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	return s_budget;
+}
+
+bool GpuMemory::IsOverBudget()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	return s_overBudget;
+}
+
+const char* GpuMemory::GetCategoryName(Category a_category)
+{
+	return (a_category < Category_Count) ? s_categoryNames[a_category] : "";
+}
+
+const char* GpuMemory::GetFormatName(unsigned int a_format)
+{
+	switch (a_format)
+	{
+	case 0: return "-";
+	case GL_RGBA8: return "RGBA8";
+	case GL_SRGB8_ALPHA8: return "SRGB8_A8";
+	case GL_RGB8: return "RGB8";
+	case GL_RG8: return "RG8";
+	case GL_R8: return "R8";
+	case GL_RGBA16F: return "RGBA16F";
+	case GL_RGBA32F: return "RGBA32F";
+	case GL_DEPTH24_STENCIL8: return "D24S8";
+	case GL_DEPTH_COMPONENT32F: return "D32F";
+	default: return "?";
+	}
+}
+
+// Bytes per texel of the uncompressed formats the framework uses
+static size_t TexelBytes(unsigned int a_format)
+{
+	switch (a_format)
+	{
+	case GL_R8: return 1;
+	case GL_RG8: return 2;
+	case GL_RGB8: return 3;
+	case GL_RGBA16F: return 8;
+	case GL_RGBA32F: return 16;
+	default: return 4;	// RGBA8, SRGB8_ALPHA8, depth and depth/stencil
+	}
+}
+
+size_t GpuMemory::TextureBytes(unsigned int a_format, unsigned int a_width, unsigned int a_height, unsigned int a_layers, unsigned int a_mipLevels)
+{
+	size_t texels = 0;
+	for (unsigned int level = 0; level < a_mipLevels; ++level)
+	{
+		size_t width = (a_width >> level) > 0 ? (a_width >> level) : 1;
+		size_t height = (a_height >> level) > 0 ? (a_height >> level) : 1;
+		texels += width * height;
+	}
+	return texels * a_layers * TexelBytes(a_format);
+}
@@ -0,0 +1,208 @@
+#include "GpuProfiler.h"
+#include "FrameStats.h"
+#include "MemoryStats.h"
+
+#include <glad/glad.h>
+#include <cstring>
+#include <iostream>
+
+GpuProfiler* GpuProfiler::m_instance = nullptr;
+
+GpuProfiler* GpuProfiler::CreateInstance()
+{
+	if (m_instance == nullptr)
+	{
+		m_instance = new GpuProfiler();
+	}
+	return m_instance;
+}
+
+GpuProfiler* GpuProfiler::GetInstance()
+{
+	return m_instance;
+}
+
+void GpuProfiler::DestroyInstance()
+{
+	if (m_instance != nullptr)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+GpuProfiler::GpuProfiler() : m_initialised(false), m_frames(), m_frameIndex(0), m_currentFrame(nullptr),
+	m_recordStack(), m_scopeStack(), m_stackDepth(0), m_droppedFrames(0), m_lastFrameTime(0.f)
+{
+	// Scopes are only ever added, a handful covers the whole renderer
+	m_scopes.reserve(32);
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	if (m_initialised)
+	{
+		for (FrameQueries& frame : m_frames)
+		{
+			glDeleteQueries(MaxScopesPerFrame * 2, frame.queries);
+		}
+	}
+}
+
+void GpuProfiler::BeginFrame()
+{
+	// New scopes and the published stats only allocate from here down
+	MemoryTagScope memoryTag(MemoryStats::Profiling);
+	if (!m_initialised)
+	{
+		// Query objects need the context, which may live on the render thread, so they're made on first use
+		for (FrameQueries& frame : m_frames)
+		{
+			glGenQueries(MaxScopesPerFrame * 2, frame.queries);
+		}
+		m_initialised = true;
+	}
+	// This slot was last used FrameLatency frames ago, read it back before reusing its queries
+	m_currentFrame = &m_frames[m_frameIndex % FrameLatency];
+	if (m_currentFrame->pending)
+	{
+		ResolveFrame(*m_currentFrame);
+	}
+	m_currentFrame->recordCount = 0;
+	m_stackDepth = 0;
+	BeginScope("Frame");
+}
+
+void GpuProfiler::EndFrame()
+{
+	MemoryTagScope memoryTag(MemoryStats::Profiling);
+	if (m_currentFrame == nullptr) { return; }
+	// Close anything left open so a missing EndScope can't corrupt the next frame
+	while (m_stackDepth > 0)
+	{
+		EndScope();
+	}
+	m_currentFrame->pending = m_currentFrame->recordCount > 0;
+	m_currentFrame = nullptr;
+	++m_frameIndex;
+}
+
+void GpuProfiler::BeginScope(const char* a_name)
+{
+	MemoryTagScope memoryTag(MemoryStats::Profiling);
+	if (m_currentFrame == nullptr || m_stackDepth >= MaxScopeDepth) { return; }
+	unsigned int parent = (m_stackDepth > 0) ? m_scopeStack[m_stackDepth - 1] : NoScope;
+	unsigned int scope = FindScope(a_name, parent);
+	unsigned int record = NoScope;
+	if (m_currentFrame->recordCount < MaxScopesPerFrame)
+	{
+		record = m_currentFrame->recordCount++;
+		ScopeRecord& scopeRecord = m_currentFrame->records[record];
+		scopeRecord.scope = scope;
+		scopeRecord.beginQuery = m_currentFrame->queries[record * 2];
+		scopeRecord.endQuery = m_currentFrame->queries[record * 2 + 1];
+		glQueryCounter(scopeRecord.beginQuery, GL_TIMESTAMP);
+	}
+	m_recordStack[m_stackDepth] = record;
+	m_scopeStack[m_stackDepth] = scope;
+	++m_stackDepth;
+}
+
+void GpuProfiler::EndScope()
+{
+	if (m_currentFrame == nullptr || m_stackDepth == 0) { return; }
+	--m_stackDepth;
+	unsigned int record = m_recordStack[m_stackDepth];
+	if (record != NoScope)
+	{
+		glQueryCounter(m_currentFrame->records[record].endQuery, GL_TIMESTAMP);
+	}
+}
+
+unsigned int GpuProfiler::FindScope(const char* a_name, unsigned int a_parent)
+{
+	for (unsigned int i = 0; i < m_scopes.size(); ++i)
+	{
+		if (m_scopes[i].parent == a_parent && strcmp(m_scopes[i].name, a_name) == 0) { return i; }
+	}
+	Scope scope = {};
+	scope.name = a_name;
+	scope.parent = a_parent;
+	scope.depth = (a_parent == NoScope) ? 0 : m_scopes[a_parent].depth + 1;
+	m_scopes.push_back(scope);
+	return (unsigned int)m_scopes.size() - 1;
+}
+
+void GpuProfiler::ResolveFrame(FrameQueries& a_frame)
+{
+	a_frame.pending = false;
+	// Queries complete in order and the root scope's end timestamp was the last one issued,
+	// so once that's available the rest of the frame is too
+	int available = GL_FALSE;
+	glGetQueryObjectiv(a_frame.records[0].endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available == GL_FALSE)
+	{
+		++m_droppedFrames;
+		return;
+	}
+	for (unsigned int i = 0; i < a_frame.recordCount; ++i)
+	{
+		const ScopeRecord& record = a_frame.records[i];
+		GLuint64 beginTime = 0, endTime = 0;
+		glGetQueryObjectui64v(record.beginQuery, GL_QUERY_RESULT, &beginTime);
+		glGetQueryObjectui64v(record.endQuery, GL_QUERY_RESULT, &endTime);
+		float ms = (endTime > beginTime) ? (float)((endTime - beginTime) / 1000000.0) : 0.f;
+
+		Scope& scope = m_scopes[record.scope];
+		scope.lastMs = ms;
+		scope.history[scope.historyHead] = ms;
+		scope.historyHead = (scope.historyHead + 1) % HistoryLength;
+		if (scope.historyCount < HistoryLength) { ++scope.historyCount; }
+		float total = 0.f, maximum = 0.f;
+		for (unsigned int h = 0; h < scope.historyCount; ++h)
+		{
+			total += scope.history[h];
+			maximum = (scope.history[h] > maximum) ? scope.history[h] : maximum;
+		}
+		scope.averageMs = total / scope.historyCount;
+		scope.maxMs = maximum;
+	}
+	// Feed the root scope into the frame time percentiles
+	if (FrameStats* frameStats = FrameStats::GetInstance())
+	{
+		frameStats->RecordGpuFrame(m_scopes[a_frame.records[0].scope].lastMs);
+	}
+	PublishStats();
+}
+
+void GpuProfiler::PublishStats()
+{
+	std::lock_guard<std::mutex> lock(m_statsMutex);
+	m_stats.clear();
+	AppendChildren(NoScope, m_stats);
+	// The root Frame scope is the first one ever opened
+	m_lastFrameTime = m_scopes.empty() ? 0.f : m_scopes[0].lastMs;
+}
+
+void GpuProfiler::AppendChildren(unsigned int a_parent, std::vector<ScopeStats>& a_stats) const
+{
+	for (unsigned int i = 0; i < m_scopes.size(); ++i)
+	{
+		if (m_scopes[i].parent != a_parent) { continue; }
+		const Scope& scope = m_scopes[i];
+		a_stats.push_back(ScopeStats{ scope.name, scope.depth, scope.lastMs, scope.averageMs, scope.maxMs });
+		AppendChildren(i, a_stats);
+	}
+}
+
+void GpuProfiler::GetStats(std::vector<ScopeStats>& a_stats) const
+{
+	std::lock_guard<std::mutex> lock(m_statsMutex);
+	a_stats = m_stats;
+}
+
+float GpuProfiler::GetLastFrameTime() const
+{
+	std::lock_guard<std::mutex> lock(m_statsMutex);
+	return m_lastFrameTime;
+}
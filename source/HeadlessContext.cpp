@@ -0,0 +1,161 @@
+#include "HeadlessContext.h"
+#include "GpuMemory.h"
+
+#include <glad/glad.h>
+#include <iostream>
+
+#ifndef _WIN32
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+HeadlessContext::HeadlessContext(unsigned int a_width, unsigned int a_height) :
+	m_width(a_width), m_height(a_height), m_display(nullptr), m_context(nullptr), m_framebuffer(0), m_colourBuffer(0), m_depthBuffer(0)
+{
+}
+
+HeadlessContext::~HeadlessContext()
+{
+#ifndef _WIN32
+	if (m_context != nullptr)
+	{
+		// The framebuffer belongs to the context, it only needs deleting if the context is still current here
+		if (eglGetCurrentContext() == (EGLContext)m_context && m_framebuffer != 0)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			GpuMemory::ReleaseRenderbuffer(m_colourBuffer);
+			GpuMemory::ReleaseRenderbuffer(m_depthBuffer);
+			glDeleteFramebuffers(1, &m_framebuffer);
+			glDeleteRenderbuffers(1, &m_colourBuffer);
+			glDeleteRenderbuffers(1, &m_depthBuffer);
+		}
+		eglMakeCurrent((EGLDisplay)m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext((EGLDisplay)m_display, (EGLContext)m_context);
+	}
+	if (m_display != nullptr)
+	{
+		eglTerminate((EGLDisplay)m_display);
+	}
+#endif
+}
+
+HeadlessContext* HeadlessContext::Create(unsigned int a_width, unsigned int a_height)
+{
+#ifdef _WIN32
+	(void)a_width; (void)a_height;
+	return nullptr;
+#else
+	// Mesa's surfaceless platform needs neither a display server nor a GPU, fall back to the default display otherwise
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay != nullptr)
+	{
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY)
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+	EGLint major = 0, minor = 0;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		std::cout << "Headless: unable to initialise EGL" << std::endl;
+		return nullptr;
+	}
+	HeadlessContext* context = new HeadlessContext(a_width, a_height);
+	context->m_display = display;
+
+	// The default surface type is window, which surfaceless displays don't have, pbuffer configs are the offscreen ones
+	const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_NONE };
+	EGLConfig config = nullptr;
+	EGLint configCount = 0;
+	if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+	{
+		std::cout << "Headless: no desktop OpenGL config available through EGL" << std::endl;
+		delete context;
+		return nullptr;
+	}
+	// The renderer expects what a default GLFW window gives, a compatibility context with GL 4.4+ features
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 5,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT, EGL_NONE };
+	EGLContext glContext = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (glContext == EGL_NO_CONTEXT)
+	{
+		// Let the driver pick, whatever it gives is checked once GL is loaded
+		glContext = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+	}
+	if (glContext == EGL_NO_CONTEXT)
+	{
+		std::cout << "Headless: unable to create an OpenGL context" << std::endl;
+		delete context;
+		return nullptr;
+	}
+	context->m_context = glContext;
+	if (!context->MakeCurrent())
+	{
+		std::cout << "Headless: the driver doesn't support surfaceless contexts" << std::endl;
+		delete context;
+		return nullptr;
+	}
+	std::cout << "Headless EGL " << major << "." << minor << " context created" << std::endl;
+	return context;
+#endif
+}
+
+void* HeadlessContext::GetProcAddress(const char* a_name)
+{
+#ifdef _WIN32
+	(void)a_name;
+	return nullptr;
+#else
+	return (void*)eglGetProcAddress(a_name);
+#endif
+}
+
+bool HeadlessContext::CreateFramebuffer()
+{
+	// sRGB colour so GL_FRAMEBUFFER_SRGB behaves as it does on the window's sRGB capable back buffer
+	glGenRenderbuffers(1, &m_colourBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colourBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_SRGB8_ALPHA8, m_width, m_height);
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	GpuMemory::RecordRenderbuffer(m_colourBuffer, GL_SRGB8_ALPHA8, m_width, m_height, "Headless colour");
+	GpuMemory::RecordRenderbuffer(m_depthBuffer, GL_DEPTH24_STENCIL8, m_width, m_height, "Headless depth");
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colourBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Headless: offscreen framebuffer is incomplete" << std::endl;
+		return false;
+	}
+	// Nothing else binds a framebuffer so this stays the draw target for the whole run
+	return true;
+}
+
+bool HeadlessContext::MakeCurrent()
+{
+#ifdef _WIN32
+	return false;
+#else
+	return eglMakeCurrent((EGLDisplay)m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, (EGLContext)m_context) == EGL_TRUE;
+#endif
+}
+
+void HeadlessContext::ReleaseCurrent()
+{
+#ifndef _WIN32
+	eglMakeCurrent((EGLDisplay)m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+#endif
+}
+
+void HeadlessContext::Present()
+{
+	glFinish();
+}
@@ -0,0 +1,310 @@
+#include "JobSystem.h"
+#include "CpuProfiler.h"
+
+#include <iostream>
+#include <string>
+
+// Static instance initialised to nullptr
+JobSystem* JobSystem::m_instance = nullptr;
+
+// Which job system (if any) the current thread belongs to and its worker index in it
+static thread_local JobSystem* tls_jobSystem = nullptr;
+static thread_local int tls_workerIndex = -1;
+
+#pragma region JobDeque
+bool JobDeque::Push(Job* a_job)
+{
+	long long bottom = m_bottom.load(std::memory_order_relaxed);
+	long long top = m_top.load(std::memory_order_acquire);
+	if (bottom - top >= Capacity)
+	{
+		return false;
+	}
+	m_jobs[bottom & (Capacity - 1)].store(a_job, std::memory_order_relaxed);
+	// Release so a thief that sees the new bottom also sees the job
+	m_bottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+Job* JobDeque::Pop()
+{
+	long long bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	// The owner and thieves must agree on the order of bottom and top here
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	long long top = m_top.load(std::memory_order_relaxed);
+	if (top > bottom)
+	{
+		// Empty, put bottom back
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	Job* job = m_jobs[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		// Last job, race any thieves for it
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			job = nullptr;
+		}
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* JobDeque::Steal()
+{
+	long long top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	long long bottom = m_bottom.load(std::memory_order_acquire);
+	if (top >= bottom)
+	{
+		return nullptr;
+	}
+	Job* job = m_jobs[top & (Capacity - 1)].load(std::memory_order_relaxed);
+	// Someone else (the owner or another thief) may have taken it first
+	if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return nullptr;
+	}
+	return job;
+}
+
+long long JobDeque::Size() const
+{
+	long long size = m_bottom.load(std::memory_order_relaxed) - m_top.load(std::memory_order_relaxed);
+	return size > 0 ? size : 0;
+}
+#pragma endregion JobDeque
+
+JobSystem::JobSystem(unsigned int a_workerCount) :
+	m_running(true), m_steals(0), m_sleepingWorkers(0), m_jobGeneration(0), m_blockedCount(0)
+{
+	m_blockedJobs.reserve(JobRingSize);
+	// Slot 0 belongs to the creating thread, then one per background worker
+	for (unsigned int i = 0; i <= a_workerCount; ++i)
+	{
+		m_workers.push_back(new WorkerData());
+	}
+	tls_jobSystem = this;
+	tls_workerIndex = 0;
+	for (unsigned int i = 1; i <= a_workerCount; ++i)
+	{
+		m_threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+	std::cout << "Job system started with " << a_workerCount << " worker thread(s)" << std::endl;
+}
+
+JobSystem::~JobSystem()
+{
+	// Finish off anything still queued on this thread, or parked waiting for a worker's job, before stopping the workers
+	while (ExecuteOne(0) || m_blockedCount.load() > 0) {}
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_running.store(false);
+	}
+	m_wake.notify_all();
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+	for (WorkerData* worker : m_workers)
+	{
+		delete worker;
+	}
+	if (tls_jobSystem == this)
+	{
+		tls_jobSystem = nullptr;
+		tls_workerIndex = -1;
+	}
+}
+
+int JobSystem::ThreadIndex() const
+{
+	return tls_jobSystem == this ? tls_workerIndex : -1;
+}
+
+Job* JobSystem::AllocateJob(int a_index)
+{
+	// Each thread hands out jobs from its own ring. The oldest slot may still hold a job that's queued or parked on a
+	// dependency, help run jobs until it has finished rather than overwrite it
+	WorkerData* worker = m_workers[a_index];
+	Job* job = &worker->jobs[worker->nextJob & (JobRingSize - 1)];
+	// Moved on first so any job run while we wait takes the next slot, not this one
+	++worker->nextJob;
+	while (job->inUse.load(std::memory_order_acquire))
+	{
+		if (!ExecuteOne(a_index))
+		{
+			std::this_thread::yield();
+		}
+	}
+	job->inUse.store(true, std::memory_order_relaxed);
+	return job;
+}
+
+void JobSystem::Submit(int a_index, Job* a_job)
+{
+	if (!m_workers[a_index]->deque.Push(a_job))
+	{
+		// Deque is full, rather than wait just do the work now
+		Execute(a_job);
+		return;
+	}
+	m_jobGeneration.fetch_add(1);
+	if (m_sleepingWorkers.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wake.notify_one();
+	}
+}
+
+void JobSystem::WakeWorkers()
+{
+	m_jobGeneration.fetch_add(1);
+	if (m_sleepingWorkers.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wake.notify_all();
+	}
+}
+
+void JobSystem::Block(Job* a_job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_blockedMutex);
+		m_blockedJobs.push_back(a_job);
+		m_blockedCount.fetch_add(1);
+	}
+	// The last job it depends on may have finished before it saw the count go up, so nobody would wake the workers
+	if (a_job->dependency->m_value.load() == 0)
+	{
+		WakeWorkers();
+	}
+}
+
+Job* JobSystem::TakeUnblockedJob()
+{
+	if (m_blockedCount.load() == 0)
+	{
+		return nullptr;
+	}
+	std::lock_guard<std::mutex> lock(m_blockedMutex);
+	for (size_t i = 0; i < m_blockedJobs.size(); ++i)
+	{
+		Job* job = m_blockedJobs[i];
+		if (job->dependency->IsDone())
+		{
+			m_blockedJobs[i] = m_blockedJobs.back();
+			m_blockedJobs.pop_back();
+			m_blockedCount.fetch_sub(1);
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void JobSystem::Execute(Job* a_job)
+{
+	if (a_job->dependency && !a_job->dependency->IsDone())
+	{
+		// Help out until the job we depend on has finished
+		Wait(a_job->dependency);
+	}
+	JobCounter* counter = a_job->counter;
+	{
+		CPU_PROFILE_SCOPE("Job");
+		MemoryTagScope memoryTag(a_job->memoryTag);
+		a_job->execute(a_job);
+	}
+	// Finished with the slot, its ring can hand it out again
+	a_job->inUse.store(false, std::memory_order_release);
+	if (counter && counter->m_value.fetch_sub(1) == 1 && m_blockedCount.load() > 0)
+	{
+		// Something parked may have been waiting on this counter
+		WakeWorkers();
+	}
+}
+
+bool JobSystem::ExecuteOne(int a_index)
+{
+	// Parked jobs that are ready now go first, they've already waited
+	Job* job = TakeUnblockedJob();
+	if (job == nullptr)
+	{
+		job = m_workers[a_index]->deque.Pop();
+	}
+	if (job == nullptr)
+	{
+		// Our own deque is empty, go round the other threads and try to steal from them
+		unsigned int count = GetThreadCount();
+		for (unsigned int i = 1; i < count && job == nullptr; ++i)
+		{
+			job = m_workers[(a_index + i) % count]->deque.Steal();
+		}
+		if (job == nullptr)
+		{
+			return false;
+		}
+		m_steals.fetch_add(1, std::memory_order_relaxed);
+	}
+	if (job->dependency && !job->dependency->IsDone())
+	{
+		// Not ready yet. Pushing it back would only pop it again from the bottom, park it so the jobs under it can run
+		Block(job);
+		return true;
+	}
+	Execute(job);
+	return true;
+}
+
+void JobSystem::Wait(const JobCounter* a_counter)
+{
+	int index = ThreadIndex();
+	while (!a_counter->IsDone())
+	{
+		if (index < 0 || !ExecuteOne(index))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool JobSystem::ExecutePendingJob()
+{
+	int index = ThreadIndex();
+	return index >= 0 && ExecuteOne(index);
+}
+
+void JobSystem::WorkerLoop(unsigned int a_index)
+{
+	tls_jobSystem = this;
+	tls_workerIndex = (int)a_index;
+	if (CpuProfiler* profiler = CpuProfiler::GetInstance())
+	{
+		profiler->SetThreadName(("Worker " + std::to_string(a_index)).c_str());
+	}
+	unsigned int idleSpins = 0;
+	while (m_running.load(std::memory_order_relaxed))
+	{
+		unsigned long long generation = m_jobGeneration.load();
+		if (ExecuteOne(a_index))
+		{
+			idleSpins = 0;
+			continue;
+		}
+		// Spin for a little while as more work usually turns up quickly, then go to sleep
+		if (++idleSpins < 64)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		m_sleepingWorkers.fetch_add(1);
+		{
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_wake.wait(lock, [this, generation]() { return !m_running.load() || m_jobGeneration.load() != generation; });
+		}
+		m_sleepingWorkers.fetch_sub(1);
+		idleSpins = 0;
+	}
+}
@@ -0,0 +1,191 @@
+#include "MemoryStats.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<unsigned long long> s_allocationCount(0);
+static std::atomic<long long> s_liveBytes(0);
+static std::atomic<long long> s_peakBytes(0);
+
+typedef struct TagCounters
+{
+	std::atomic<long long> liveBytes;
+	std::atomic<long long> peakBytes;
+	std::atomic<long long> liveAllocations;
+	std::atomic<unsigned long long> totalAllocations;
+} TagCounters;
+static TagCounters s_tags[MemoryStats::Tag_Count];
+static std::atomic<long long> s_baselineBytes[MemoryStats::Tag_Count];
+static std::atomic<long long> s_baselineAllocations[MemoryStats::Tag_Count];
+// Bumped by MarkBaseline, allocations stamped with an older epoch are part of the baseline
+static std::atomic<unsigned int> s_baselineEpoch(0);
+
+static thread_local MemoryStats::Tag tls_tag = MemoryStats::General;
+
+static const char* s_tagNames[MemoryStats::Tag_Count] = { "General", "Loader", "Textures", "Shaders", "Events", "UI", "Renderer", "Profiling", "Driver" };
+
+// Sits in front of every tracked allocation, padded so the memory handed out keeps malloc's alignment
+typedef struct AllocationHeader
+{
+	size_t size;
+	unsigned int tag;
+	unsigned int epoch;
+} AllocationHeader;
+static const size_t s_headerSize = (sizeof(AllocationHeader) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+static void RaisePeak(std::atomic<long long>& a_peak, long long a_value)
+{
+	long long peak = a_peak.load(std::memory_order_relaxed);
+	while (a_value > peak && !a_peak.compare_exchange_weak(peak, a_value, std::memory_order_relaxed)) {}
+}
+
+static void* TrackedAllocate(size_t a_size, MemoryStats::Tag a_tag)
+{
+	AllocationHeader* header = static_cast<AllocationHeader*>(malloc(s_headerSize + a_size));
+	if (header == nullptr) { return nullptr; }
+	header->size = a_size;
+	header->tag = a_tag;
+	header->epoch = s_baselineEpoch.load(std::memory_order_relaxed);
+
+	s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	RaisePeak(s_peakBytes, s_liveBytes.fetch_add((long long)a_size, std::memory_order_relaxed) + (long long)a_size);
+	TagCounters& counters = s_tags[a_tag];
+	RaisePeak(counters.peakBytes, counters.liveBytes.fetch_add((long long)a_size, std::memory_order_relaxed) + (long long)a_size);
+	counters.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+	counters.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+	return reinterpret_cast<unsigned char*>(header) + s_headerSize;
+}
+
+static void TrackedFree(void* a_memory)
+{
+	if (a_memory == nullptr) { return; }
+	AllocationHeader* header = reinterpret_cast<AllocationHeader*>(static_cast<unsigned char*>(a_memory) - s_headerSize);
+	// Freed under whichever tag it was allocated with, whatever thread frees it
+	s_liveBytes.fetch_sub((long long)header->size, std::memory_order_relaxed);
+	TagCounters& counters = s_tags[header->tag];
+	counters.liveBytes.fetch_sub((long long)header->size, std::memory_order_relaxed);
+	counters.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+	if (header->epoch != s_baselineEpoch.load(std::memory_order_relaxed))
+	{
+		// Allocated before the baseline was taken, it's no longer live so it's no longer part of it
+		s_baselineBytes[header->tag].fetch_sub((long long)header->size, std::memory_order_relaxed);
+		s_baselineAllocations[header->tag].fetch_sub(1, std::memory_order_relaxed);
+	}
+	free(header);
+}
+
+unsigned long long MemoryStats::GetAllocationCount()
+{
+	return s_allocationCount.load(std::memory_order_relaxed);
+}
+
+long long MemoryStats::GetLiveBytes()
+{
+	return s_liveBytes.load(std::memory_order_relaxed);
+}
+
+long long MemoryStats::GetPeakBytes()
+{
+	return s_peakBytes.load(std::memory_order_relaxed);
+}
+
+MemoryStats::TagStats MemoryStats::GetTagStats(Tag a_tag)
+{
+	const TagCounters& counters = s_tags[a_tag];
+	TagStats stats = { counters.liveBytes.load(std::memory_order_relaxed), counters.peakBytes.load(std::memory_order_relaxed),
+		counters.liveAllocations.load(std::memory_order_relaxed), counters.totalAllocations.load(std::memory_order_relaxed) };
+	return stats;
+}
+
+const char* MemoryStats::GetTagName(Tag a_tag)
+{
+	return (a_tag < Tag_Count) ? s_tagNames[a_tag] : "";
+}
+
+MemoryStats::Tag MemoryStats::SetThreadTag(Tag a_tag)
+{
+	Tag previous = tls_tag;
+	tls_tag = a_tag;
+	return previous;
+}
+
+MemoryStats::Tag MemoryStats::GetThreadTag()
+{
+	return tls_tag;
+}
+
+void* MemoryStats::Allocate(size_t a_size, Tag a_tag)
+{
+	return TrackedAllocate(a_size, a_tag);
+}
+
+void MemoryStats::Free(void* a_memory)
+{
+	TrackedFree(a_memory);
+}
+
+void MemoryStats::MarkBaseline()
+{
+	// Only the calling thread should be allocating while this runs, or the odd allocation lands on the wrong side of it
+	s_baselineEpoch.fetch_add(1, std::memory_order_relaxed);
+	for (int i = 0; i < Tag_Count; ++i)
+	{
+		s_baselineBytes[i].store(s_tags[i].liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		s_baselineAllocations[i].store(s_tags[i].liveAllocations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+}
+
+bool MemoryStats::ReportLeaks()
+{
+	// printf rather than cout, this runs at the very end and shouldn't allocate while it reports
+	bool leaked = false;
+	for (int i = 0; i < Tag_Count; ++i)
+	{
+		if (i == Driver) { continue; }
+		long long bytes = s_tags[i].liveBytes.load(std::memory_order_relaxed) - s_baselineBytes[i].load(std::memory_order_relaxed);
+		long long allocations = s_tags[i].liveAllocations.load(std::memory_order_relaxed) - s_baselineAllocations[i].load(std::memory_order_relaxed);
+		if (allocations == 0 && bytes == 0) { continue; }
+		if (!leaked) { printf("Memory still allocated at shutdown:\n"); }
+		leaked = true;
+		printf("  %-10s %lld bytes in %lld allocations (peak %lld bytes)\n", s_tagNames[i], bytes, allocations,
+			s_tags[i].peakBytes.load(std::memory_order_relaxed));
+	}
+	if (!leaked) { printf("No leaked allocations\n"); }
+	return leaked;
+}
+
+#pragma region Global new/delete
+// Replacements for the global allocation functions, they track and forward to malloc/free
+void* operator new(size_t a_size)
+{
+	// malloc(0) may return null, new must return a unique pointer
+	void* memory = TrackedAllocate(a_size > 0 ? a_size : 1, tls_tag);
+	if (memory == nullptr) { throw std::bad_alloc(); }
+	return memory;
+}
+
+void* operator new[](size_t a_size)
+{
+	return operator new(a_size);
+}
+
+void* operator new(size_t a_size, const std::nothrow_t&) noexcept
+{
+	return TrackedAllocate(a_size > 0 ? a_size : 1, tls_tag);
+}
+
+void* operator new[](size_t a_size, const std::nothrow_t& a_nothrow) noexcept
+{
+	return operator new(a_size, a_nothrow);
+}
+
+void operator delete(void* a_memory) noexcept { TrackedFree(a_memory); }
+void operator delete[](void* a_memory) noexcept { TrackedFree(a_memory); }
+void operator delete(void* a_memory, size_t) noexcept { TrackedFree(a_memory); }
+void operator delete[](void* a_memory, size_t) noexcept { TrackedFree(a_memory); }
+void operator delete(void* a_memory, const std::nothrow_t&) noexcept { TrackedFree(a_memory); }
+void operator delete[](void* a_memory, const std::nothrow_t&) noexcept { TrackedFree(a_memory); }
+#pragma endregion Global new/delete
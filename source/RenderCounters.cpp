@@ -0,0 +1,43 @@
+#include "RenderCounters.h"
+
+#include <cstring>
+#include <mutex>
+
+std::atomic<bool> RenderCounters::s_enabled(true);
+unsigned long long RenderCounters::s_current[RenderCounters::Counter_Count] = {};
+
+// Published copy of the last frame, written once per frame by the GL thread
+static std::mutex s_publishMutex;
+static unsigned long long s_lastFrame[RenderCounters::Counter_Count] = {};
+static unsigned long long s_frameIndex = 0;
+
+static const char* s_counterNames[RenderCounters::Counter_Count] = {
+	"Draw calls", "Triangles", "Lines", "Program binds", "Texture binds", "Buffer binds", "VAO binds",
+	"Uniform updates", "State changes", "Buffer uploads", "Buffer bytes", "Texture uploads", "Texture bytes" };
+
+void RenderCounters::EndFrame()
+{
+	{
+		std::lock_guard<std::mutex> lock(s_publishMutex);
+		memcpy(s_lastFrame, s_current, sizeof(s_current));
+		++s_frameIndex;
+	}
+	memset(s_current, 0, sizeof(s_current));
+}
+
+void RenderCounters::GetLastFrame(unsigned long long (&a_counters)[Counter_Count])
+{
+	std::lock_guard<std::mutex> lock(s_publishMutex);
+	memcpy(a_counters, s_lastFrame, sizeof(s_lastFrame));
+}
+
+unsigned long long RenderCounters::GetFrameIndex()
+{
+	std::lock_guard<std::mutex> lock(s_publishMutex);
+	return s_frameIndex;
+}
+
+const char* RenderCounters::GetName(Counter a_counter)
+{
+	return (a_counter < Counter_Count) ? s_counterNames[a_counter] : "";
+}
@@ -1,16 +1,28 @@
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <iostream>
+#include <algorithm>
+#include <cfloat>
 #include <imgui.h>
 
 #include "RenderFramework.h"
 #include "Dispatcher.h"
+#include "Benchmarks.h"
+#include "JobSystem.h"
+#include "FrameAllocator.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "FrameStats.h"
+#include "RenderCounters.h"
+#include "Telemetry.h"
+#include "MemoryStats.h"
+#include "GpuMemory.h"
 #include "ShaderUtil.h"
 #include "Utilities.h"
 #include "TextureManager.h"
-#include "obj_loader.h"
+#include "BufferManager.h"
+#include "obj_Loader.h"
 #include "Texture.h"
 #include "ApplicationEvent.h"
 #include "Texture.h"
@@ -28,12 +40,14 @@ RenderFramework::~RenderFramework()
 // Setting up our application - So the Update loop doesn't have to fully re-implement the 3D world each frame
 bool RenderFramework::onCreate()
 {
+    // Everything set up here belongs to the renderer unless a narrower tag says otherwise
+    MemoryTagScope memoryTag(MemoryStats::Renderer);
     // Getting an instance of our dispatcher
     Dispatcher* dp = Dispatcher::GetInstance();
     if (dp)
     {
         // Subscribing our window resize member function
-        dp->Subscribe(this, &RenderFramework::onWindowResize);
+        m_resizeSubscription = dp->Subscribe<&RenderFramework::onWindowResize>(this);
     }
 
     // Get an instance of the texture manager
@@ -44,11 +58,11 @@ bool RenderFramework::onCreate()
     
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
+    // Filter across cubemap face edges so the skybox mips don't show seams
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
     //create shader program
-    unsigned int vertexShader = ShaderUtil::loadShader("resource/shaders/vertex.glsl", GL_VERTEX_SHADER);
-    unsigned int fragmentShader = ShaderUtil::loadShader("resource/shaders/fragment.glsl", GL_FRAGMENT_SHADER);
-    m_uiProgram = ShaderUtil::createProgram(vertexShader, fragmentShader);
+    m_uiProgram = ShaderUtil::loadProgramAsync("resource/shaders/vertex.glsl", "resource/shaders/fragment.glsl");
 
     // Create a grid of lines to be drawn during our update
     // Create a 10x10 square grid
@@ -69,10 +83,14 @@ bool RenderFramework::onCreate()
 
     // Create a vertex buffer to hold our line data
 
-    glGenBuffers(1, &m_lineVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_lineVBO);
+    BufferManager* pBM = BufferManager::CreateInstance();
+    m_lineVBO = pBM->CreateBuffer();
+    glBindBuffer(GL_ARRAY_BUFFER, pBM->GetBufferID(m_lineVBO));
     // Fill vertex buffer with line data
     glBufferData(GL_ARRAY_BUFFER, 42 * sizeof(Line), m_lines, GL_STATIC_DRAW);
+    GpuMemory::RecordBuffer(pBM->GetBufferID(m_lineVBO), GpuMemory::VertexBuffers, 42 * sizeof(Line), "Grid");
+    RENDER_COUNT(BufferUploads, 1);
+    RENDER_COUNT(BufferBytesUploaded, 42 * sizeof(Line));
 
     // enables the vertex array state, since we're sending in an array of vertices
     glEnableVertexAttribArray(0);
@@ -101,42 +119,97 @@ bool RenderFramework::onCreate()
             glm::pi<float>() * 0.25f,
             m_windowWidth / (float)m_windowHeight,
             0.1f, 1000.0f);
+    m_viewportWidth = m_windowWidth;
+    m_viewportHeight = m_windowHeight;
 
 #pragma region Model & Material Loading
 
     m_specularTint = glm::vec3(1.f, 0.f, 0.f);
     m_objModel = new OBJModel();
-    if (m_objModel->load("resource/models/D0208009.obj"))
+    bool modelLoaded;
     {
+        // The loader is its own library, so OBJ and MTL parsing show up together under this zone
+        CPU_PROFILE_SCOPE("OBJ Load");
+        TelemetryLoadPhase loadPhase("OBJ Load");
+        MemoryTagScope loaderTag(MemoryStats::Loader);
+        modelLoaded = m_objModel->load(m_modelPath.c_str());
+    }
+    if (modelLoaded)
+    {
+        CPU_PROFILE_SCOPE("Material Textures");
+        TelemetryLoadPhase loadPhase("Material Textures");
         TextureManager* pTM = TextureManager::GetInstance();
-        // Load in texture for model if any are present
-        for (int i = 0; i < m_objModel->getMaterialCount(); ++i)
+        if (m_useTextureArrays)
         {
-            OBJMaterial* mat = m_objModel->getMaterialByIndex(i);
+            // Pack each texture role into texture arrays, materials then reference a layer rather than their own texture
             for (int n = 0; n < OBJMaterial::TextureTypes::TextureTypes_Count; ++n)
             {
-                if (mat->textureFileNames[n].size() > 0)
+                std::vector<std::string> filenames;
+                for (unsigned int i = 0; i < m_objModel->getMaterialCount(); ++i)
                 {
-                    unsigned int textureID = pTM->LoadTexture(mat->textureFileNames[n].c_str());
-                    mat->textureIDs[n] = textureID;
+                    filenames.push_back(m_objModel->getMaterialByIndex(i)->textureFileNames[n]);
+                }
+                std::vector<TextureManager::TextureArraySlot> slots;
+                // Only the diffuse map holds colour, specular and normal maps are data and must be sampled linearly
+                pTM->LoadTextureArrays(filenames, slots, n == OBJMaterial::TextureTypes::DiffuseTexture);
+                for (unsigned int i = 0; i < m_objModel->getMaterialCount(); ++i)
+                {
+                    OBJMaterial* mat = m_objModel->getMaterialByIndex(i);
+                    mat->textureIDs[n] = pTM->GetTextureID(slots[i].texture);
+                    mat->textureLayers[n] = slots[i].layer;
+                    // Materials only keep the GL name, the handles are held here so Destroy can release them
+                    if (slots[i].texture.IsValid()) { m_materialTextures.push_back(slots[i].texture); }
                 }
             }
         }
-        // Setup shaders for obj model rendering
-        // create OBJ shader prograp[']
-
-        unsigned int obj_vertexShader = ShaderUtil::loadShader("resource/shaders/obj_vertex.glsl", GL_VERTEX_SHADER);
-        unsigned int obj_fragmentShader = ShaderUtil::loadShader("resource/shaders/obj_fragment.glsl", GL_FRAGMENT_SHADER);
-        m_objProgram = ShaderUtil::createProgram(obj_vertexShader, obj_fragmentShader);
+        else
+        {
+            // Load in texture for model if any are present
+            for (unsigned int i = 0; i < m_objModel->getMaterialCount(); ++i)
+            {
+                OBJMaterial* mat = m_objModel->getMaterialByIndex(i);
+                for (int n = 0; n < OBJMaterial::TextureTypes::TextureTypes_Count; ++n)
+                {
+                    if (mat->textureFileNames[n][0] != '\0')
+                    {
+                        TextureHandle texture = pTM->LoadTexture(mat->textureFileNames[n], n == OBJMaterial::TextureTypes::DiffuseTexture);
+                        mat->textureIDs[n] = pTM->GetTextureID(texture);
+                        if (texture.IsValid()) { m_materialTextures.push_back(texture); }
+                    }
+                }
+            }
+        }
+        std::cout << "Texture deduplication saved " << pTM->GetBytesSaved() / 1024 << " KB" << std::endl;
+        // OBJ shaders are specialised per material, Draw asks ShaderUtil for each variant the first time it's needed
         // Set up vertex and index buffer for OBJ rendering
-        glGenBuffers(2, m_objModelBuffer);
+        m_objModelBuffer[0] = pBM->CreateBuffer();
+        m_objModelBuffer[1] = pBM->CreateBuffer();
         // Set up vertex buffer data
-        glBindBuffer(GL_ARRAY_BUFFER, m_objModelBuffer[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, pBM->GetBufferID(m_objModelBuffer[0]));
 
         glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        // Model space bounds for each mesh so the cull task can test them against the camera frustum
+        m_meshBounds.resize(m_objModel->getMeshCount());
+        // Materials don't change after loading so each mesh's shader variant can be worked out once here
+        m_meshFeatures.resize(m_objModel->getMeshCount());
+        for (unsigned int i = 0; i < m_objModel->getMeshCount(); ++i)
+        {
+            OBJMesh* pMesh = m_objModel->getMeshByIndex(i);
+            m_meshFeatures[i] = GetMaterialFeatures(pMesh->m_material);
+            MeshBounds& bounds = m_meshBounds[i];
+            bounds.min = glm::vec3(FLT_MAX);
+            bounds.max = glm::vec3(-FLT_MAX);
+            for (const OBJVertex& vertex : pMesh->m_vertices)
+            {
+                bounds.min = glm::min(bounds.min, glm::vec3(vertex.position));
+                bounds.max = glm::max(bounds.max, glm::vec3(vertex.position));
+            }
+        }
+        SetupFrameGraph();
     }
     else {
-        std::cout << "Failed to Load Model" << std::endl;
+        std::cout << "Failed to Load Model: " << m_modelPath << std::endl;
         return false;
     }
 #pragma endregion Model & Material Loading
@@ -147,16 +220,13 @@ bool RenderFramework::onCreate()
     std::vector<std::string> textures_faces = { "resource/skybox/right.jpg", "resource/skybox/left.jpg",
                                                  "resource/skybox/top.jpg", "resource/skybox/bottom.jpg",
                                                  "resource/skybox/front.jpg", "resource/skybox/back.jpg" };
-    unsigned int cubemap_image_tag[6] = { GL_TEXTURE_CUBE_MAP_POSITIVE_X,  GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
-                                            GL_TEXTURE_CUBE_MAP_POSITIVE_Y,  GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
-                                            GL_TEXTURE_CUBE_MAP_POSITIVE_Z,  GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, };
-
-    Texture* pTexture = new Texture();
-    m_CubeMaptextID = pTexture->LoadCubeMap(textures_faces, cubemap_image_tag);
+    // Faces are decoded in parallel and cached by the texture manager
+    {
+        TelemetryLoadPhase loadPhase("Skybox");
+        m_CubeMapTexture = TextureManager::GetInstance()->LoadCubeMap(textures_faces);
+    }
     
-    vertexShader = ShaderUtil::loadShader("resource/shaders/skybox_vertex.glsl",GL_VERTEX_SHADER);
-    fragmentShader = ShaderUtil::loadShader("resource/shaders/skybox_fragment.glsl",GL_FRAGMENT_SHADER);
-    m_SBProgramID = ShaderUtil::createProgram(vertexShader, fragmentShader);
+    m_SBProgram = ShaderUtil::loadProgramAsync("resource/shaders/skybox_vertex.glsl", "resource/shaders/skybox_fragment.glsl");
 
     float skyboxVertices[] = {
         // positions          
@@ -204,10 +274,11 @@ bool RenderFramework::onCreate()
     };
 
     // Create a vertex buffer for the skybox
-    glGenBuffers(1, &m_SBVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_SBVBO);
+    m_SBVBO = pBM->CreateBuffer();
+    glBindBuffer(GL_ARRAY_BUFFER, pBM->GetBufferID(m_SBVBO));
     // Fill vertex buffer with line data
     glBufferStorage(GL_ARRAY_BUFFER, sizeof(float) * 108, skyboxVertices, 0);
+    GpuMemory::RecordBuffer(pBM->GetBufferID(m_SBVBO), GpuMemory::VertexBuffers, sizeof(float) * 108, "Skybox");
     // Generate our vertex array object
     glGenVertexArrays(1, &m_SBVAO);
     glBindVertexArray(m_SBVAO);
@@ -217,7 +288,7 @@ bool RenderFramework::onCreate()
 
     // Specify where our vertex array is, how many components each vertex has, the data type for each component, and whether the data is normalised
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, m_SBVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, pBM->GetBufferID(m_SBVBO));
 
     glBindVertexArray(0);
 
@@ -230,172 +301,469 @@ bool RenderFramework::onCreate()
 
 #pragma endregion OnCreate
 
-void RenderFramework::Update(float deltaTime)
+#pragma region Frame Graph
+void RenderFramework::SetupFrameGraph()
 {
+    // Sized once here so the tasks never allocate during the frame
+    unsigned int meshCount = m_objModel->getMeshCount();
+    m_meshVisible.resize(meshCount);
+    m_drawCommands.reserve(meshCount);
+    for (FrameSnapshot& snapshot : m_snapshots)
+    {
+        snapshot.drawCommands.reserve(meshCount);
+    }
+
+    // Input and ImGui have to stay on the main thread, the rest can go wide on the job system
+    m_frameGraph.AddTask("Camera", [this]() { UpdateCamera(); }, {}, { CameraResource }, true);
+    m_frameGraph.AddTask("UI", [this]() { UpdateUI(); }, {}, { SettingsResource }, true);
+    m_frameGraph.AddTask("Cull", [this]() { CullMeshes(); }, { CameraResource }, { VisibilityResource });
+    m_frameGraph.AddTask("Sort", [this]() { SortDrawList(); }, { VisibilityResource }, { DrawListResource });
+    m_frameGraph.AddTask("Build Commands", [this]() { BuildDrawCommands(); }, { DrawListResource }, { DrawCommandsResource });
+}
+
+void RenderFramework::UpdateCamera()
+{
+    CPU_PROFILE_FUNCTION();
     // Updating the camera matrix based on mouse and keyboard input
+    Utilities::freeMovement(m_window, m_cameraMatrix, m_deltaTime, 3.f);
+
+    // Get the view matrix from the world-space camera matrix
+    glm::mat4 viewMatrix = glm::inverse(m_cameraMatrix);
+    m_projectionViewMatrix = m_projectionMatrix * viewMatrix;
+
+    // Pull the frustum planes out of the projection-view matrix (left, right, bottom, top, near, far)
+    glm::mat4 m = glm::transpose(m_projectionViewMatrix);
+    m_frustumPlanes[0] = m[3] + m[0];
+    m_frustumPlanes[1] = m[3] - m[0];
+    m_frustumPlanes[2] = m[3] + m[1];
+    m_frustumPlanes[3] = m[3] - m[1];
+    m_frustumPlanes[4] = m[3] + m[2];
+    m_frustumPlanes[5] = m[3] - m[2];
+    for (glm::vec4& plane : m_frustumPlanes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
 
-    Utilities::freeMovement(m_cameraMatrix, deltaTime, 3.f);
+void RenderFramework::UpdateUI()
+{
+    CPU_PROFILE_FUNCTION();
     // Implementing IMGUI windows
-    
     MainMenu(m_bMy_tool_active);
     if (m_changeColour)
     {
         ChangeBackgroundColour(&m_backgroundColour, &m_specularTint);
     }
-  
+    if (m_showFrameStats)
+    {
+        FrameStatsWindow();
+    }
 }
 
-void RenderFramework::Draw()
-{ 
-    glDepthFunc(GL_LESS);
-    // Clear the backbuffer
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-   
-    glClearColor(m_backgroundColour.x, m_backgroundColour.y, m_backgroundColour.z, 1.f);
-
-    // Get the view matrix from the world-space camera matrix
-    glm::mat4 viewMatrix = glm::inverse(m_cameraMatrix);
-    glm::mat4 projectionViewMatrix = m_projectionMatrix * viewMatrix;
-
-    //Enable shaders
-    glUseProgram(m_uiProgram);
-
-    // Send the projection matrix to the vertex shader
-    // Ask the shader program for the location of the projection-view matrix uniform variable
-    unsigned int projectionViewUniformLocation = glGetUniformLocation(m_uiProgram, "ProjectionViewMatrix");
-    // Send this location a pointer to our glm::mat4 (send across float data)
-    glUniformMatrix4fv(projectionViewUniformLocation, 1, false, glm::value_ptr(projectionViewMatrix));
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_lineVBO);
-    glBufferData(GL_ARRAY_BUFFER, 42 * sizeof(Line), m_lines, GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-
-    // Specify where our vertex array is, how many components each vertex has,
-    // the data type of each component and whehter the data is normalised or not
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), ((char*)0) + 16);
-
-    glDrawArrays(GL_LINES, 0, 42 * 2);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    glUseProgram(0);
-
-    glUseProgram(m_objProgram);
-    // Set the projection view matrix for this shader
-    projectionViewUniformLocation = glGetUniformLocation(m_objProgram, "ProjectionViewMatrix");
-    glUniformMatrix4fv(projectionViewUniformLocation, 1, GL_FALSE, glm::value_ptr(projectionViewMatrix));
+void RenderFramework::CullMeshes()
+{
+    CPU_PROFILE_FUNCTION();
+    const glm::mat4& worldMatrix = m_objModel->getWorldMatrix();
+    // Absolute value of the rotation/scale part, used to find the world space extents of a box
+    glm::mat3 absWorld = glm::mat3(glm::abs(glm::vec3(worldMatrix[0])), glm::abs(glm::vec3(worldMatrix[1])), glm::abs(glm::vec3(worldMatrix[2])));
+    const glm::vec4* planes = m_frustumPlanes;
+    const MeshBounds* bounds = m_meshBounds.data();
+    unsigned char* visible = m_meshVisible.data();
+
+    auto cull = [&](size_t a_begin, size_t a_end)
+    {
+        for (size_t i = a_begin; i < a_end; ++i)
+        {
+            glm::vec3 center = glm::vec3(worldMatrix * glm::vec4((bounds[i].min + bounds[i].max) * 0.5f, 1.f));
+            glm::vec3 extents = absWorld * ((bounds[i].max - bounds[i].min) * 0.5f);
+            bool inside = true;
+            for (int p = 0; p < 6 && inside; ++p)
+            {
+                // Box is outside if it's entirely behind any plane
+                float distance = glm::dot(glm::vec3(planes[p]), center) + planes[p].w;
+                float radius = glm::dot(glm::abs(glm::vec3(planes[p])), extents);
+                inside = distance + radius >= 0.f;
+            }
+            visible[i] = inside ? 1 : 0;
+        }
+    };
+    if (JobSystem* jobs = JobSystem::GetInstance())
+    {
+        jobs->ParallelFor(m_meshVisible.size(), 64, cull);
+    }
+    else
+    {
+        cull(0, m_meshVisible.size());
+    }
+}
 
-    for (int i = 0; i < m_objModel->getMeshCount(); ++i)
+void RenderFramework::SortDrawList()
+{
+    CPU_PROFILE_FUNCTION();
+    // Scratch list for this frame, gone once the draw commands are built
+    m_drawList = FrameAllocator::GetInstance()->AllocateArray<unsigned int>(m_meshVisible.size());
+    m_drawListCount = 0;
+    for (unsigned int i = 0; i < m_meshVisible.size(); ++i)
     {
-        // Get the model matrix location from the shader program
-        int modelMatrirxUniformLocation = glGetUniformLocation(m_objProgram, "ModelMatrix");
-        // Send the OBJ model's world matrix data across to the shader program
-        glUniformMatrix4fv(modelMatrirxUniformLocation, 1, false, glm::value_ptr(m_objModel->getWorldMatrix()));
-
-        int cameraPositionUniformLocation = glGetUniformLocation(m_objProgram, "camPos");
-        glUniform4fv(cameraPositionUniformLocation, 1, glm::value_ptr(m_cameraMatrix[3]));
-        
-        OBJMesh* pMesh = m_objModel->getMeshByIndex(i);
-        // Send material data to shader
-        int kA_location = glGetUniformLocation(m_objProgram, "kA");
-        int kD_location = glGetUniformLocation(m_objProgram, "kD");
-        int kS_location = glGetUniformLocation(m_objProgram, "kS");
+        if (m_meshVisible[i]) { m_drawList[m_drawListCount++] = i; }
+    }
+    // Group meshes by shader variant and then by their textures so the submission switches and rebinds as little as possible
+    OBJModel* model = m_objModel;
+    const unsigned int* features = m_meshFeatures.data();
+    std::sort(m_drawList, m_drawList + m_drawListCount, [model, features](unsigned int a_lhs, unsigned int a_rhs)
+    {
+        if (features[a_lhs] != features[a_rhs]) { return features[a_lhs] < features[a_rhs]; }
+        const OBJMaterial* lhs = model->getMeshByIndex(a_lhs)->m_material;
+        const OBJMaterial* rhs = model->getMeshByIndex(a_rhs)->m_material;
+        for (int n = 0; n < OBJMaterial::TextureTypes::TextureTypes_Count; ++n)
+        {
+            unsigned int lhsID = lhs ? lhs->textureIDs[n] : 0;
+            unsigned int rhsID = rhs ? rhs->textureIDs[n] : 0;
+            if (lhsID != rhsID) { return lhsID < rhsID; }
+        }
+        return a_lhs < a_rhs;
+    });
+}
 
-        OBJMaterial* pMaterial = pMesh->m_material;
-        if (pMaterial != nullptr)
+void RenderFramework::BuildDrawCommands()
+{
+    CPU_PROFILE_FUNCTION();
+    static_assert(OBJMaterial::TextureTypes::TextureTypes_Count == 3, "DrawCommand expects diffuse, specular and normal textures");
+    m_drawCommands.resize(m_drawListCount);
+    OBJModel* model = m_objModel;
+    const unsigned int* drawList = m_drawList;
+    const unsigned int* features = m_meshFeatures.data();
+    DrawCommand* commands = m_drawCommands.data();
+
+    auto build = [&](size_t a_begin, size_t a_end)
+    {
+        for (size_t i = a_begin; i < a_end; ++i)
         {
-            // Send the OBJ Model's world matrix data across to the shader program
-            glUniform4fv(kA_location, 1, glm::value_ptr(pMaterial->Get_kA()));
-            glUniform4fv(kD_location, 1, glm::value_ptr(pMaterial->Get_kD()));
-            glUniform4fv(kS_location, 1, glm::value_ptr(pMaterial->Get_kS()));
+            DrawCommand& command = commands[i];
+            command.mesh = model->getMeshByIndex(drawList[i]);
+            command.features = features[drawList[i]];
+            OBJMaterial* pMaterial = command.mesh->m_material;
+            command.hasMaterial = pMaterial != nullptr;
+            if (pMaterial != nullptr)
+            {
+                command.kA = pMaterial->Get_kA();
+                command.kD = pMaterial->Get_kD();
+                command.kS = pMaterial->Get_kS();
+                for (int n = 0; n < OBJMaterial::TextureTypes::TextureTypes_Count; ++n)
+                {
+                    command.textureIDs[n] = pMaterial->textureIDs[n];
+                    command.textureLayers[n] = pMaterial->textureLayers[n];
+                }
+            }
+            else // No material to obtain lighting information from use defaults
+            {
+                command.kA = glm::vec4(0.25f, 0.25f, 0.25f, 1.f);
+                command.kD = glm::vec4(1.f, 1.f, 1.f, 1.f);
+                command.kS = glm::vec4(1.f, 1.f, 1.f, 64.f);
+            }
+        }
+    };
+    if (JobSystem* jobs = JobSystem::GetInstance())
+    {
+        jobs->ParallelFor(m_drawCommands.size(), 64, build);
+    }
+    else
+    {
+        build(0, m_drawCommands.size());
+    }
+}
 
-            // Get the location of the diffuse texture
-            int texUniformLoc = glGetUniformLocation(m_objProgram, "DiffuseTexture");
-            glUniform1i(texUniformLoc, 0); // set diffuse texture to be GL_Texture0
+unsigned int RenderFramework::GetMaterialFeatures(const OBJMaterial* a_pMaterial) const
+{
+    unsigned int features = m_useTextureArrays ? static_cast<unsigned int>(TextureArrayFeature) : 0u;
+    if (a_pMaterial == nullptr)
+    {
+        // Meshes without a material are lit with the default white, specular material
+        return features | SpecularFeature;
+    }
+    if (a_pMaterial->textureIDs[OBJMaterial::TextureTypes::DiffuseTexture] != 0) { features |= DiffuseMapFeature; }
+    if (a_pMaterial->textureIDs[OBJMaterial::TextureTypes::SpecularTexture] != 0) { features |= SpecularMapFeature; }
+    if (a_pMaterial->textureIDs[OBJMaterial::TextureTypes::NormalTexture] != 0) { features |= NormalMapFeature; }
+    const glm::vec4& kS = a_pMaterial->Get_kS();
+    if (kS.x > 0.f || kS.y > 0.f || kS.z > 0.f) { features |= SpecularFeature; }
+    // Dissolve is kept in kD's alpha
+    if (a_pMaterial->Get_kD().a < 1.f) { features |= AlphaTestFeature; }
+    return features;
+}
+#pragma endregion Frame Graph
 
-            glActiveTexture(GL_TEXTURE0); // set the active texture unit to texture0
-            // Bind the texture for diffuse for this material to the texture 0
-            glBindTexture(GL_TEXTURE_2D, pMaterial->textureIDs[OBJMaterial::TextureTypes::DiffuseTexture]);
+void RenderFramework::Update(float deltaTime)
+{
+    // Camera, UI, culling, sorting and draw command building all run through the frame graph
+    m_deltaTime = deltaTime;
+    m_frameGraph.Execute(JobSystem::GetInstance());
+}
 
-            // Get the location of the diffuse texture
-            texUniformLoc = glGetUniformLocation(m_objProgram, "SpecularTexture");
-            glUniform1i(texUniformLoc, 1); // set diffuse texture to be GL_Texturel
+void RenderFramework::CaptureFrame(unsigned int a_slot)
+{
+    FrameSnapshot& snapshot = m_snapshots[a_slot];
+    snapshot.projectionViewMatrix = m_projectionViewMatrix;
+    snapshot.cameraPosition = m_cameraMatrix[3];
+    snapshot.backgroundColour = m_backgroundColour;
+    snapshot.specularTint = m_specularTint;
+    snapshot.lightDirection = m_lightDirection;
+    snapshot.viewportWidth = m_viewportWidth;
+    snapshot.viewportHeight = m_viewportHeight;
+    // Capacity was reserved up front so this is just a copy
+    snapshot.drawCommands.assign(m_drawCommands.begin(), m_drawCommands.end());
+}
 
-            glActiveTexture(GL_TEXTURE1); // set the active texture unit to texture1
+void RenderFramework::Draw()
+{ 
+    // Only read from the snapshot here, with the render thread on Update is already working on the next frame
+    const FrameSnapshot& frame = m_snapshots[m_renderSlot];
+    glViewport(0, 0, frame.viewportWidth, frame.viewportHeight);
+    glDepthFunc(GL_LESS);
+    // Lighting is done in linear space, let the hardware encode the result to sRGB on write
+    glEnable(GL_FRAMEBUFFER_SRGB);
+    RENDER_COUNT(StateChanges, 2);
+    // Clear the backbuffer
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+   
+    // The background colour is picked in sRGB, convert it to linear as the framebuffer will re-encode it
+    glm::vec3 linearBackground = glm::pow(frame.backgroundColour, glm::vec3(2.2f));
+    glClearColor(linearBackground.x, linearBackground.y, linearBackground.z, 1.f);
+
+    // The camera task has already built the projection-view matrix for this frame
+    const glm::mat4& projectionViewMatrix = frame.projectionViewMatrix;
+
+    // Pick up any programs that finished compiling since the last frame
+    ShaderUtil::pollPrograms();
+    // Resolve the resource handles once for the frame, each lookup is a couple of array reads
+    unsigned int uiProgram = ShaderUtil::getProgramID(m_uiProgram);
+    unsigned int skyboxProgram = ShaderUtil::getProgramID(m_SBProgram);
+    BufferManager* pBM = BufferManager::GetInstance();
+    unsigned int lineVBO = pBM->GetBufferID(m_lineVBO);
+    unsigned int objVertexBuffer = pBM->GetBufferID(m_objModelBuffer[0]);
+    unsigned int objIndexBuffer = pBM->GetBufferID(m_objModelBuffer[1]);
+    unsigned int cubeMapTexture = TextureManager::GetInstance()->GetTextureID(m_CubeMapTexture);
+
+    // Programs are compiled asynchronously, a pass is skipped until its program is ready
+    if (uiProgram != 0)
+    {
+        GpuProfileScope gpuScope("Grid");
+        //Enable shaders
+        glUseProgram(uiProgram);
+        RENDER_COUNT(ProgramBinds, 1);
+
+        // Send the projection matrix to the vertex shader
+        // Ask the shader program for the location of the projection-view matrix uniform variable
+        int projectionViewUniformLocation = glGetUniformLocation(uiProgram, "ProjectionViewMatrix");
+        // Send this location a pointer to our glm::mat4 (send across float data)
+        glUniformMatrix4fv(projectionViewUniformLocation, 1, false, glm::value_ptr(projectionViewMatrix));
+        RENDER_COUNT(UniformUpdates, 1);
+
+        glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
+        glBufferData(GL_ARRAY_BUFFER, 42 * sizeof(Line), m_lines, GL_STATIC_DRAW);
+        GpuMemory::RecordBuffer(lineVBO, GpuMemory::VertexBuffers, 42 * sizeof(Line), "Grid");
+        RENDER_COUNT(BufferBinds, 1);
+        RENDER_COUNT(BufferUploads, 1);
+        RENDER_COUNT(BufferBytesUploaded, 42 * sizeof(Line));
+
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        RENDER_COUNT(StateChanges, 2);
+
+        // Specify where our vertex array is, how many components each vertex has,
+        // the data type of each component and whehter the data is normalised or not
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), ((char*)0) + 16);
+
+        glDrawArrays(GL_LINES, 0, 42 * 2);
+        RENDER_COUNT(DrawCalls, 1);
+        RENDER_COUNT(Lines, 42);
 
-            int specularTintUniform = glGetUniformLocation(m_objProgram, "specularTint");
-            glUniform3fv(specularTintUniform, 1, glm::value_ptr(m_specularTint));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-            // Bind the texture for diffuse for this material to the texture0
-            glBindTexture(GL_TEXTURE_2D, pMaterial->textureIDs[OBJMaterial::TextureTypes::SpecularTexture]);
+        glUseProgram(0);
+    }
 
-            // Get the location of the diffuse texture
-            texUniformLoc = glGetUniformLocation(m_objProgram, "NormalTexture");
-            glUniform1i(texUniformLoc, 2); // Set diffuse texture to be GL_Texture2
+    // Names for each ObjShaderFeatures bit, injected as #defines into the obj shader variants
+    static const char* const s_objFeatureDefines[ObjShaderFeatures_Count] = {
+        "HAS_DIFFUSE_MAP", "HAS_SPECULAR_MAP", "HAS_NORMAL_MAP", "HAS_SPECULAR", "ALPHA_TEST", "USE_TEXTURE_ARRAYS" };
+    // Texture arrays let consecutive meshes with different materials share the same bindings
+    unsigned int textureTarget = m_useTextureArrays ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+    // Start from an invalid ID so the first material always binds, texture 0 is a valid binding for materials without a map
+    unsigned int boundTextures[OBJMaterial::TextureTypes::TextureTypes_Count] = { (unsigned int)-1, (unsigned int)-1, (unsigned int)-1 };
+    unsigned int currentFeatures = (unsigned int)-1;
+    unsigned int objProgram = 0;
+    int kA_location = -1;
+    int kD_location = -1;
+    int kS_location = -1;
+    int layersUniformLoc = -1;
+
+    GpuProfiler* gpuProfiler = GpuProfiler::GetInstance();
+    if (gpuProfiler) { gpuProfiler->BeginScope("OBJ Meshes"); }
+    glEnableVertexAttribArray(0);   // Position
+    glEnableVertexAttribArray(1);   // Normal 
+    glEnableVertexAttribArray(2);   // UV Coord
+    RENDER_COUNT(StateChanges, 3);
+
+    // Submit the draw commands the frame graph built, they're already culled and sorted by shader variant then texture
+    for (const DrawCommand& command : frame.drawCommands)
+    {
+        if (command.features != currentFeatures)
+        {
+            // First mesh of a new variant, switch program and set the uniforms that are the same for every mesh
+            currentFeatures = command.features;
+            ProgramHandle variant = ShaderUtil::getProgramVariant("resource/shaders/obj_vertex.glsl", "resource/shaders/obj_fragment.glsl",
+                currentFeatures, s_objFeatureDefines, ObjShaderFeatures_Count);
+            objProgram = ShaderUtil::getProgramID(variant);
+            if (objProgram == 0) { continue; }
+
+            glUseProgram(objProgram);
+            RENDER_COUNT(ProgramBinds, 1);
+            // Set the projection view matrix for this shader
+            int projectionViewUniformLocation = glGetUniformLocation(objProgram, "ProjectionViewMatrix");
+            glUniformMatrix4fv(projectionViewUniformLocation, 1, GL_FALSE, glm::value_ptr(projectionViewMatrix));
+            int modelMatrirxUniformLocation = glGetUniformLocation(objProgram, "ModelMatrix");
+            glUniformMatrix4fv(modelMatrirxUniformLocation, 1, false, glm::value_ptr(m_objModel->getWorldMatrix()));
+            int cameraPositionUniformLocation = glGetUniformLocation(objProgram, "camPos");
+            glUniform4fv(cameraPositionUniformLocation, 1, glm::value_ptr(frame.cameraPosition));
+            int specularTintUniform = glGetUniformLocation(objProgram, "specularTint");
+            glUniform3fv(specularTintUniform, 1, glm::value_ptr(frame.specularTint));
+            glUniform3fv(glGetUniformLocation(objProgram, "LightDirection"), 1, glm::value_ptr(frame.lightDirection));
+            // Samplers are fixed to units 0, 1 and 2
+            glUniform1i(glGetUniformLocation(objProgram, "DiffuseTexture"), 0);
+            glUniform1i(glGetUniformLocation(objProgram, "SpecularTexture"), 1);
+            glUniform1i(glGetUniformLocation(objProgram, "NormalTexture"), 2);
+            RENDER_COUNT(UniformUpdates, 8);
+
+            kA_location = glGetUniformLocation(objProgram, "kA");
+            kD_location = glGetUniformLocation(objProgram, "kD");
+            kS_location = glGetUniformLocation(objProgram, "kS");
+            layersUniformLoc = glGetUniformLocation(objProgram, "TextureLayers");
+        }
+        // This variant is still compiling, its meshes pop in once it's ready
+        if (objProgram == 0) { continue; }
 
-            glActiveTexture(GL_TEXTURE2); // Set the active texture unit to texture2
-            // Bind the texture for diffuse for this material to the texture
-            glBindTexture(GL_TEXTURE_2D, pMaterial->textureIDs[OBJMaterial::TextureTypes::NormalTexture]);
+        OBJMesh* pMesh = command.mesh;
+        // Send material data to shader
+        glUniform4fv(kA_location, 1, glm::value_ptr(command.kA));
+        glUniform4fv(kD_location, 1, glm::value_ptr(command.kD));
+        glUniform4fv(kS_location, 1, glm::value_ptr(command.kS));
+        RENDER_COUNT(UniformUpdates, 3);
 
-        }
-        else // No material to obtain lighting information from use defaults
+        if (command.hasMaterial)
         {
-            glUniform4fv(kA_location, 1, glm::value_ptr(glm::vec4(0.25f, 0.25f, 0.25f, 1.f)));
-            glUniform4fv(kD_location, 1, glm::value_ptr(glm::vec4(1.f, 1.f, 1.f, 1.f)));
-            glUniform4fv(kS_location, 1, glm::value_ptr(glm::vec4(1.f, 1.f, 1.f, 64.f)));
+            // Only rebind a texture unit when this material uses a different texture (or texture array) to the last one
+            for (int n = 0; n < OBJMaterial::TextureTypes::TextureTypes_Count; ++n)
+            {
+                if (boundTextures[n] != command.textureIDs[n])
+                {
+                    glActiveTexture(GL_TEXTURE0 + n);
+                    glBindTexture(textureTarget, command.textureIDs[n]);
+                    boundTextures[n] = command.textureIDs[n];
+                    RENDER_COUNT(TextureBinds, 1);
+                }
+            }
+
+            if (m_useTextureArrays)
+            {
+                // Select this material's layer within each array
+                glUniform3i(layersUniformLoc,
+                    command.textureLayers[OBJMaterial::TextureTypes::DiffuseTexture],
+                    command.textureLayers[OBJMaterial::TextureTypes::SpecularTexture],
+                    command.textureLayers[OBJMaterial::TextureTypes::NormalTexture]);
+                RENDER_COUNT(UniformUpdates, 1);
+            }
         }
-        
-        glBindBuffer(GL_ARRAY_BUFFER, m_objModelBuffer[0]);
+    
+        glBindBuffer(GL_ARRAY_BUFFER, objVertexBuffer);
         glBufferData(GL_ARRAY_BUFFER, pMesh->m_vertices.size() * sizeof(OBJVertex), pMesh->m_vertices.data(), GL_STATIC_DRAW);
+        GpuMemory::RecordBuffer(objVertexBuffer, GpuMemory::VertexBuffers, pMesh->m_vertices.size() * sizeof(OBJVertex), "OBJ meshes");
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_objModelBuffer[1]);
-        glEnableVertexAttribArray(0);   // Position
-        glEnableVertexAttribArray(1);   // Normal 
-        glEnableVertexAttribArray(2);   // UV Coord
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, objIndexBuffer);
 
         glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(OBJVertex), ((char*)0) + OBJVertex::PositionOffset);
         glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(OBJVertex), ((char*)0) + OBJVertex::NormalOffset);
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(OBJVertex), ((char*)0) + OBJVertex::UVCoordOffset);
 
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, pMesh->m_indices.size() * sizeof(unsigned int), pMesh->m_indices.data(), GL_STATIC_DRAW);
+        GpuMemory::RecordBuffer(objIndexBuffer, GpuMemory::IndexBuffers, pMesh->m_indices.size() * sizeof(unsigned int), "OBJ meshes");
         glDrawElements(GL_TRIANGLES, pMesh->m_indices.size(), GL_UNSIGNED_INT, 0);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
+        // Both buffers are re-specified for every mesh every frame, which is exactly what BufferBytesUploaded is here to show
+        RENDER_COUNT(BufferBinds, 4);
+        RENDER_COUNT(BufferUploads, 2);
+        RENDER_COUNT(BufferBytesUploaded, pMesh->m_vertices.size() * sizeof(OBJVertex) + pMesh->m_indices.size() * sizeof(unsigned int));
+        RENDER_COUNT(DrawCalls, 1);
+        RENDER_COUNT(Triangles, pMesh->m_indices.size() / 3);
     }
 
     glDisableVertexAttribArray(0);
     glDisableVertexAttribArray(1);
     glDisableVertexAttribArray(2);
+    RENDER_COUNT(StateChanges, 3);
+    if (gpuProfiler) { gpuProfiler->EndScope(); }
 
     //glUseProgram(0);
 
     // Draw the Skybox
-    glDepthFunc(GL_LEQUAL);
-    glUseProgram(m_SBProgramID);
-    //glDepthMask(GL_FALSE);
-
-    //projectionViewMatrix = glm::mat4(glm::mat3(projectionViewMatrix));
-    projectionViewUniformLocation = glGetUniformLocation(m_SBProgramID, "ProjectionViewMatrix");
-    glUniformMatrix4fv(projectionViewUniformLocation, 1, false, glm::value_ptr(projectionViewMatrix));
-
-    glBindVertexArray(m_SBVAO);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_CubeMaptextID);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glDepthMask(GL_TRUE);
-    glUseProgram(0);
+    if (skyboxProgram != 0)
+    {
+        GpuProfileScope gpuScope("Skybox");
+        glDepthFunc(GL_LEQUAL);
+        glUseProgram(skyboxProgram);
+        RENDER_COUNT(StateChanges, 1);
+        RENDER_COUNT(ProgramBinds, 1);
+        //glDepthMask(GL_FALSE);
+
+        //projectionViewMatrix = glm::mat4(glm::mat3(projectionViewMatrix));
+        int projectionViewUniformLocation = glGetUniformLocation(skyboxProgram, "ProjectionViewMatrix");
+        glUniformMatrix4fv(projectionViewUniformLocation, 1, false, glm::value_ptr(projectionViewMatrix));
+        RENDER_COUNT(UniformUpdates, 1);
+
+        glBindVertexArray(m_SBVAO);
+        RENDER_COUNT(VertexArrayBinds, 1);
+        // The skybox sampler reads from unit 0, the mesh loop may have left another unit active
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, cubeMapTexture);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+        glDepthMask(GL_TRUE);
+        RENDER_COUNT(TextureBinds, 1);
+        RENDER_COUNT(DrawCalls, 1);
+        RENDER_COUNT(Triangles, 12);
+        RENDER_COUNT(StateChanges, 1);
+        glUseProgram(0);
+    }
+    // ImGui colours are already in display space so don't convert its output
+    glDisable(GL_FRAMEBUFFER_SRGB);
+    RENDER_COUNT(StateChanges, 1);
 
 
 }
 
 void RenderFramework::Destroy()
 {
+    if (Dispatcher* dp = Dispatcher::GetInstance())
+    {
+        dp->Unsubscribe(m_resizeSubscription);
+    }
     delete m_objModel;
-    delete[] lines;
-    glDeleteBuffers(1, &m_lineVBO);
+    delete[] m_lines;
+    m_lines = nullptr;
+    BufferManager* pBM = BufferManager::GetInstance();
+    pBM->DestroyBuffer(m_lineVBO);
+    pBM->DestroyBuffer(m_objModelBuffer[0]);
+    pBM->DestroyBuffer(m_objModelBuffer[1]);
+    pBM->DestroyBuffer(m_SBVBO);
     ShaderUtil::deleteProgram(m_uiProgram);
+    ShaderUtil::deleteProgram(m_SBProgram);
+    TextureManager* pTM = TextureManager::GetInstance();
+    for (TextureHandle texture : m_materialTextures)
+    {
+        pTM->ReleaseTexture(texture);
+    }
+    m_materialTextures.clear();
+    pTM->ReleaseTexture(m_CubeMapTexture);
+    BufferManager::DestroyInstance();
     TextureManager::DestroyInstance();
     ShaderUtil::DestroyInstance();
 }
@@ -406,7 +774,9 @@ void RenderFramework::onWindowResize(WindowResizeEvent* e)
     if (e->GetWidth() > 0 && e->GetHeight() > 0)
     {
         m_projectionMatrix = glm::perspective(glm::pi<float>() * 0.25f, e->GetWidth() / (float)e->GetHeight(), 0.1f, 1000.0f);
-        glViewport(0, 0, e->GetWidth(), e->GetHeight());
+        // Draw applies the viewport as it may be on the render thread
+        m_viewportWidth = e->GetWidth();
+        m_viewportHeight = e->GetHeight();
         e->Handled();
     }
 }
@@ -419,7 +789,7 @@ void RenderFramework::ChangeBackgroundColour(glm::vec3* a_backgroundColor, glm::
     static int corner = 0;
     
     ImGuiIO& io = ImGui::GetIO();
-    ImVec2 window_size = ImVec2(400.f, 100.f);
+    ImVec2 window_size = ImVec2(400.f, 125.f);
    // ImVec2 window_pos = ImVec2(io.DisplaySize.x * 0.01f, io.DisplaySize.y * 0.9f);
     ImVec2 window_pos = ImVec2((corner & 1) ? io.DisplaySize.x - X_DISTANCE : X_DISTANCE, (corner & 2) ? io.DisplaySize.y - Y_DISTANCE : Y_DISTANCE);
     ImGui::SetNextWindowPos(window_pos);
@@ -428,10 +798,71 @@ void RenderFramework::ChangeBackgroundColour(glm::vec3* a_backgroundColor, glm::
     {
         ImGui::ColorEdit3("Background Colour: ", glm::value_ptr(*a_backgroundColor));
         ImGui::ColorEdit3("Specular Tint", glm::value_ptr(*a_specilarTint));
+        ImGui::SliderFloat3("Light Direction", glm::value_ptr(m_lightDirection), -10.f, 10.f);
     }
     ImGui::End();   // Regardless as to weather or not this ImGui::Begin was called or not, then it needs to end.
 }
 
+void RenderFramework::FrameStatsWindow()
+{
+    FrameStats* frameStats = FrameStats::GetInstance();
+    if (frameStats == nullptr) { return; }
+    ImGui::SetNextWindowSize(ImVec2(460.f, 420.f), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Frame Statistics", &m_showFrameStats))
+    {
+        float budget = frameStats->GetBudget();
+        if (ImGui::SliderFloat("Budget (ms)", &budget, 4.f, 50.f, "%.2f"))
+        {
+            frameStats->SetBudget(budget);
+        }
+        ImGui::Text("Hitch: over %.2f ms", budget * FrameStats::HitchFactor);
+        bool countGL = RenderCounters::IsEnabled();
+        if (ImGui::Checkbox("Count GL work", &countGL))
+        {
+            RenderCounters::SetEnabled(countGL);
+        }
+
+        const char* seriesNames[FrameStats::Series_Count] = { "CPU", "GPU" };
+        for (int i = 0; i < FrameStats::Series_Count; ++i)
+        {
+            FrameStats::Series series = (FrameStats::Series)i;
+            FrameStats::Summary summary = frameStats->GetSummary(series);
+            ImGui::Separator();
+            ImGui::Text("%s  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms", seriesNames[i], summary.p50, summary.p95, summary.p99, summary.max);
+            ImGui::Text("     avg %.2f ms, %u hitches in last %u frames (%llu total)", summary.average, summary.hitches, summary.count, summary.totalHitches);
+            if (summary.count == 0) { continue; }
+
+            // Scale to the worst frame but never below the hitch line so a smooth run doesn't look noisy
+            float scaleMax = (summary.max > budget * FrameStats::HitchFactor) ? summary.max : budget * FrameStats::HitchFactor;
+            frameStats->CopySamples(series, m_frameSamples);
+            ImGui::PushID(i);
+            ImGui::PlotLines("Frame Times", m_frameSamples.data(), (int)m_frameSamples.size(), 0, nullptr, 0.f, scaleMax, ImVec2(0.f, 60.f));
+            // Half millisecond bins up to a few budgets, slower frames land in the last bin
+            frameStats->CopyHistogram(series, m_frameBins, 0.5f, budget * 4.f);
+            ImGui::PlotHistogram("Histogram", m_frameBins.data(), (int)m_frameBins.size(), 0, "0 ms - 4x budget", 0.f, FLT_MAX, ImVec2(0.f, 60.f));
+            ImGui::PopID();
+        }
+
+        // What the GPU memory is, largest first. Budget 0 means no budget
+        ImGui::Separator();
+        int gpuBudgetMB = (int)(GpuMemory::GetBudget() / (1024 * 1024));
+        if (ImGui::SliderInt("GPU budget (MB)", &gpuBudgetMB, 0, 4096))
+        {
+            GpuMemory::SetBudget((size_t)gpuBudgetMB * 1024 * 1024);
+        }
+        GpuMemory::CopyAllocations(m_gpuAllocations);
+        ImGui::Text("%u GPU allocations, peak %.1f MB", (unsigned int)m_gpuAllocations.size(), GpuMemory::GetPeakBytes() / (1024.f * 1024.f));
+        size_t shown = (m_gpuAllocations.size() < 12) ? m_gpuAllocations.size() : 12;
+        for (size_t i = 0; i < shown; ++i)
+        {
+            const GpuMemory::Allocation& allocation = m_gpuAllocations[i];
+            ImGui::Text("%8.1f KB %-14s %-8s %s", allocation.bytes / 1024.f, GpuMemory::GetCategoryName(allocation.category),
+                GpuMemory::GetFormatName(allocation.format), allocation.owner.c_str());
+        }
+    }
+    ImGui::End();
+}
+
 void RenderFramework::MainMenu(bool& m_bMy_tool_active)
 {
    
@@ -450,19 +881,23 @@ void RenderFramework::MainMenu(bool& m_bMy_tool_active)
                 if (ImGui::MenuItem("Open..", "Ctrl+O")) { /* Do stuff */ }
                 if (ImGui::MenuItem("Save", "Ctrl+S")) { /* Do stuff */ }
                 if (ImGui::MenuItem("Colour Panel")) { m_changeColour = true; }
+                if (ImGui::MenuItem("Frame Statistics")) { m_showFrameStats = true; }
                 if (ImGui::MenuItem("Close", "Ctrl+W")) { Application::Quit(); }    
                 ImGui::EndMenu();
             }
+            // Benchmarks block the frame while they run, results go to the console
+            if (ImGui::BeginMenu("Benchmarks"))
+            {
+                if (ImGui::MenuItem("Event Channel")) { Benchmarks::EventChannelThroughput(); }
+                if (ImGui::MenuItem("Job System Scaling")) { Benchmarks::JobSystemScaling(); }
+                ImGui::EndMenu();
+            }
             ImGui::EndMenuBar();
         }
 
         // Edit a color (stored as ~4 floats)
        // ImGui::ColorEdit4("Color", my_color);
 
-        // Plot some values
-        const float my_values[] = { 0.2f, 0.1f, 1.0f, 0.5f, 0.9f, 2.2f };
-        ImGui::PlotLines("Frame Times", my_values, IM_ARRAYSIZE(my_values));
-
         // Display contents in a scrolling region
         ImGui::TextColored(ImVec4(1, 1, 0, 1), "Important Stuff");
         ImGui::BeginChild("Scrolling");
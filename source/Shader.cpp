@@ -1,5 +1,6 @@
 #include <glad/glad.h>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -11,14 +12,12 @@ GLuint Shader::CreateShader(const char* a_strShaderFile, unsigned int a_eShaderT
 	//open shader file
 	std::ifstream shaderStream(a_strShaderFile);
 
-	//if that worked ok, load file line by line
+	//if that worked ok, read the whole file in one go
 	if (shaderStream.is_open())
 	{
-		std::string Line = "";
-		while (std::getline(shaderStream, Line))
-		{
-			strShaderCode += "\n" + Line;
-		}
+		std::stringstream sourceStream;
+		sourceStream << shaderStream.rdbuf();
+		strShaderCode = sourceStream.str();
 		shaderStream.close();
 	}
 
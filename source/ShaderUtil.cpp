@@ -2,9 +2,16 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
 
 #include "Utilities.h"
 #include "ShaderUtil.h"
+#include "CpuProfiler.h"
+#include "MemoryStats.h"
 
 // Single instance of ShaderUtil class - can be accessed anywhere without needing a pointer to the class object
 
@@ -48,7 +55,7 @@ void ShaderUtil::DestroyInstance()
 	}
 }
 // Private constructor
-ShaderUtil::ShaderUtil()
+ShaderUtil::ShaderUtil() : mPendingPrograms(0), mDriverHash(0), mBinaryCacheSupported(false), mParallelCompile(false), mCacheHits(0), mCacheMisses(0)
 {
 }
 
@@ -60,127 +67,580 @@ ShaderUtil::~ShaderUtil()
 	{
 		glDeleteShader(*iter);
 	}
+	mShaders.Clear();
 	// Destroy any programs that are still dangling about
 	for (auto iter = mPrograms.begin(); iter != mPrograms.end(); ++iter)
 	{
-		glDeleteProgram(*iter);
+		glDeleteShader(iter->vertexShader);
+		glDeleteShader(iter->fragmentShader);
+		glDeleteProgram(iter->program);
+	}
+	mPrograms.Clear();
+	if (mCacheHits + mCacheMisses > 0)
+	{
+		std::cout << "Shader binary cache: " << mCacheHits << " hits, " << mCacheMisses << " compiled" << std::endl;
 	}
 }
 
 // Loading shaders from a file
-unsigned int ShaderUtil::loadShader(const char* a_filename, unsigned int a_type)
+ShaderHandle ShaderUtil::loadShader(const char* a_filename, unsigned int a_type)
 {
 	ShaderUtil* instance = ShaderUtil::GetInstance();
 	return instance->loadShaderInternal(a_filename, a_type);
 }
 
-unsigned int ShaderUtil::loadShaderInternal(const char* a_filename, unsigned int a_type)
+ShaderHandle ShaderUtil::loadShaderInternal(const char* a_filename, unsigned int a_type)
 {
-	// Integer to test for shader creation success
-	int success = GL_FALSE;
 	// Grab the shader source from the file
 	char* source = Utilities::fileToBuffer(a_filename);
+	if (source == nullptr)
+	{
+		std::cout << "Unable to open shader: " << a_filename << std::endl;
+		return ShaderHandle();
+	}
+	unsigned int shader = compileShaderSource(source, a_filename, a_type);
+	// as the buffer from fileToBuffer was allocated this needs to be destroyed
+	delete[] source;
+	if (shader == 0)
+	{
+		return ShaderHandle();
+	}
+	// Success - add shader to the mShaders table and hand back a handle to it
+	return mShaders.Insert(shader);
+}
+
+unsigned int ShaderUtil::compileShaderSource(const char* a_source, const char* a_name, unsigned int a_type)
+{
+	unsigned int shader = submitShader(a_source, a_type);
+	if (!checkShaderCompiled(shader, a_name))
+	{
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+unsigned int ShaderUtil::submitShader(const char* a_source, unsigned int a_type)
+{
 	unsigned int shader = glCreateShader(a_type);
 	// Set the source buffer for the shader
-	glShaderSource(shader, 1, (const char**)&source, 0);
+	glShaderSource(shader, 1, &a_source, 0);
+	// The compiler's own caches outlive the shader, they're the driver's not ours
+	MemoryTagScope driverTag(MemoryStats::Driver);
 	glCompileShader(shader);
-	// as the buffer from fileToBuffer was allocated this needs to be destroyed
-	delete[] source;
+	return shader;
+}
+
+bool ShaderUtil::checkShaderCompiled(unsigned int a_shader, const char* a_name)
+{
+	// Integer to test for shader creation success
+	int success = GL_FALSE;
 
 	// Test shader compilation for any errors and display them to console
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	glGetShaderiv(a_shader, GL_COMPILE_STATUS, &success);
 	if (GL_FALSE == success) // shader compilation failed, get logs and display them to console
 	{
 		int infoLogLength = 0;	// Variable to store the length of the error log
-		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLogLength);
+		glGetShaderiv(a_shader, GL_INFO_LOG_LENGTH, &infoLogLength);
 		char* infoLog = new char[infoLogLength]; // allocate buffer to hold data
-		glGetShaderInfoLog(shader, infoLogLength, 0, infoLog);
-		std::cout << "Unable to compile: " << a_filename << std::endl;
+		glGetShaderInfoLog(a_shader, infoLogLength, 0, infoLog);
+		std::cout << "Unable to compile: " << a_name << std::endl;
 		std::cout << infoLog << std::endl;
 		delete[] infoLog;
-		return 0;
+		return false;
 	}
-	// Success - add shader to mShaders vector
-	mShaders.push_back(shader);
-	return shader;
+	return true;
 }
 // Deleteiong the shaders 
-void ShaderUtil::deleteShader(unsigned int a_shader)
+void ShaderUtil::deleteShader(ShaderHandle a_shader)
 {
 	ShaderUtil* instance = ShaderUtil::GetInstance();
 	instance->deleteShaderInternal(a_shader);
 }
 
-void ShaderUtil::deleteShaderInternal(unsigned int a_shader)
+void ShaderUtil::deleteShaderInternal(ShaderHandle a_shader)
 {
-	//Loop through the shaders vector
-	for (auto iter = mShaders.begin(); iter!= mShaders.end(); ++iter)
+	// Stale handles resolve to null so a double delete is caught rather than deleting someone else's shader
+	if (unsigned int* shader = mShaders.Get(a_shader))
 	{
-		if (*iter == a_shader) // if we find the shader we are looking for
-		{
-			glDeleteShader(*iter);		// Delete the shader
-			mShaders.erase(iter);		// Remove this item from the shaders vector
-			break;
-		}
+		glDeleteShader(*shader);		// Delete the shader
+		mShaders.Remove(a_shader);		// Remove this item from the shaders table
 	}
 }
 
-unsigned int ShaderUtil::createProgram(const int& a_vertexShader, const int& a_fragmentShader)
+unsigned int ShaderUtil::getShaderID(ShaderHandle a_shader)
+{
+	unsigned int* shader = ShaderUtil::GetInstance()->mShaders.Get(a_shader);
+	return (shader != nullptr) ? *shader : 0;
+}
+
+ProgramHandle ShaderUtil::createProgram(ShaderHandle a_vertexShader, ShaderHandle a_fragmentShader)
 {
 	ShaderUtil* instance = ShaderUtil::GetInstance();
 	return instance->createProgramInternal(a_vertexShader, a_fragmentShader);
 }
 
-unsigned int ShaderUtil::createProgramInternal(const int& a_vertexShader, const int& a_fragmentShader)
+ProgramHandle ShaderUtil::createProgramInternal(ShaderHandle a_vertexShader, ShaderHandle a_fragmentShader)
 {
-	//boolean value to test for shader program linkage
-	int sucess = GL_FALSE;
+	unsigned int* vertexShader = mShaders.Get(a_vertexShader);
+	unsigned int* fragmentShader = mShaders.Get(a_fragmentShader);
+	if (vertexShader == nullptr || fragmentShader == nullptr)
+	{
+		std::cout << "Shader program needs a valid vertex and fragment shader" << std::endl;
+		return ProgramHandle();
+	}
+	unsigned int program = linkProgram(*vertexShader, *fragmentShader, false);
+	if (program == 0)
+	{
+		return ProgramHandle(); // return a null handle, it resolves to program 0
+	}
+	// add the program to the shader program table
+	ProgramRecord record = { program, 0, 0, ProgramReady, 0, "", "" };
+	return mPrograms.Insert(std::move(record)); // return a handle to the program
+}
+
+unsigned int ShaderUtil::linkProgram(unsigned int a_vertexShader, unsigned int a_fragmentShader, bool a_retrievable)
+{
+	unsigned int handle = submitProgram(a_vertexShader, a_fragmentShader, a_retrievable);
+	if (!checkProgramLinked(handle))
+	{
+		glDeleteProgram(handle);
+		return 0; // return 0, programID 0 is a null program
+	}
+	// The shaders are no longer needed by this program once it has been linked
+	glDetachShader(handle, a_vertexShader);
+	glDetachShader(handle, a_fragmentShader);
+	return handle; // return the progam ID
+}
 
+unsigned int ShaderUtil::submitProgram(unsigned int a_vertexShader, unsigned int a_fragmentShader, bool a_retrievable)
+{
 	// Create a shader program and attach the shaders to it
 	unsigned int handle = glCreateProgram();
+	// The driver only has to keep the binary around if asked before linking
+	if (a_retrievable)
+	{
+		glProgramParameteri(handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	glAttachShader(handle, a_vertexShader);
 	glAttachShader(handle, a_fragmentShader);
 	// link the shaders together into one shader program
+	MemoryTagScope driverTag(MemoryStats::Driver);
 	glLinkProgram(handle);
+	return handle;
+}
+
+bool ShaderUtil::checkProgramLinked(unsigned int a_program)
+{
+	//boolean value to test for shader program linkage
+	int sucess = GL_FALSE;
 	// test to see if the program was successfully created
-	glGetProgramiv(handle, GL_LINK_STATUS, &sucess);
+	glGetProgramiv(a_program, GL_LINK_STATUS, &sucess);
 	if (GL_FALSE == sucess) // if something has gone wrong then execute the following
 	{
 		int infoLogLength = 0; //Integer value to tell us the length of the error log
-		glGetProgramiv(handle, GL_INFO_LOG_LENGTH, &infoLogLength);
+		glGetProgramiv(a_program, GL_INFO_LOG_LENGTH, &infoLogLength);
 		// alocate enough space in the buffer for the error message
 		char* infoLog = new char[infoLogLength];
 		//fill the buffer with data 
-		glGetProgramInfoLog(handle, infoLogLength, 0, infoLog);
+		glGetProgramInfoLog(a_program, infoLogLength, 0, infoLog);
 		// print log message to console
 		std::cout << "Shader Linker Error" << std::endl;
 		std::cout << infoLog << std::endl;
 
 		// delete the char buffer now we have displayed it
 		delete[] infoLog;
-		return 0; // return 0, programID 0 is a null program
+		return false;
 	}
-	// add the program to the shader program vector
-	mPrograms.push_back(handle);
-	return handle; // return the progam ID
+	return true;
 }
 
-void ShaderUtil::deleteProgram(unsigned int a_program)
+void ShaderUtil::deleteProgram(ProgramHandle a_program)
 {
 	ShaderUtil* instance = ShaderUtil::GetInstance();
 	instance->deleteProgramInternal(a_program);
 }
-void ShaderUtil::deleteProgramInternal(unsigned int a_program)
+void ShaderUtil::deleteProgramInternal(ProgramHandle a_program)
 {
-	// Loop through the shaders vector
-	for (auto iter = mPrograms.begin(); iter != mPrograms.end(); ++iter)
+	if (ProgramRecord* record = mPrograms.Get(a_program))
+	{
+		if (record->status == ProgramCompiling || record->status == ProgramLinking) { --mPendingPrograms; }
+		// Shaders are only still around if the program was deleted mid build
+		glDeleteShader(record->vertexShader);
+		glDeleteShader(record->fragmentShader);
+		glDeleteProgram(record->program);		// delete the program
+		mPrograms.Remove(a_program);	// remove this item from the programs table
+	}
+}
+
+unsigned int ShaderUtil::getProgramID(ProgramHandle a_program)
+{
+	ProgramRecord* record = ShaderUtil::GetInstance()->mPrograms.Get(a_program);
+	return (record != nullptr && record->status == ProgramReady) ? record->program : 0;
+}
+
+bool ShaderUtil::isProgramReady(ProgramHandle a_program)
+{
+	return getProgramID(a_program) != 0;
+}
+
+bool ShaderUtil::hasPendingPrograms()
+{
+	return ShaderUtil::GetInstance()->mPendingPrograms > 0;
+}
+
+ProgramHandle ShaderUtil::loadProgram(const char* a_vertexFile, const char* a_fragmentFile, const char* a_defines)
+{
+	ShaderUtil* instance = ShaderUtil::GetInstance();
+	return instance->loadProgramInternal(a_vertexFile, a_fragmentFile, a_defines != nullptr ? a_defines : "", true);
+}
+
+ProgramHandle ShaderUtil::loadProgramAsync(const char* a_vertexFile, const char* a_fragmentFile, const char* a_defines)
+{
+	ShaderUtil* instance = ShaderUtil::GetInstance();
+	return instance->loadProgramInternal(a_vertexFile, a_fragmentFile, a_defines != nullptr ? a_defines : "", false);
+}
+
+void ShaderUtil::pollPrograms()
+{
+	ShaderUtil::GetInstance()->pollProgramsInternal();
+}
+
+void ShaderUtil::pollProgramsInternal()
+{
+	if (mPendingPrograms == 0) { return; }
+	// The table is packed so this is a straight walk over the records
+	for (ProgramRecord& record : mPrograms)
 	{
-		if (*iter == a_program)			// if we find the shader we are looking for
+		if (record.status == ProgramCompiling || record.status == ProgramLinking)
 		{
-			glDeleteProgram(*iter);		// delete the shader
-			mPrograms.erase(iter);		// remove this item from the shaders vector
-			break; 
+			advanceProgram(record, false);
 		}
 	}
 }
 
+void ShaderUtil::advanceProgram(ProgramRecord& a_record, bool a_block)
+{
+	// With parallel compile this is mostly cheap polls, the real compile time is when it blocks
+	CPU_PROFILE_SCOPE("Shader Compile");
+	// Without the extension there's no way to ask if the driver has finished, so just wait on it
+	bool poll = !a_block && mParallelCompile;
+	if (a_record.status == ProgramCompiling)
+	{
+		if (poll)
+		{
+			int vertexDone = GL_FALSE, fragmentDone = GL_FALSE;
+			glGetShaderiv(a_record.vertexShader, GL_COMPLETION_STATUS_KHR, &vertexDone);
+			glGetShaderiv(a_record.fragmentShader, GL_COMPLETION_STATUS_KHR, &fragmentDone);
+			if (vertexDone == GL_FALSE || fragmentDone == GL_FALSE) { return; }
+		}
+		// Check both so both logs get printed
+		bool vertexCompiled = checkShaderCompiled(a_record.vertexShader, a_record.vertexName.c_str());
+		bool fragmentCompiled = checkShaderCompiled(a_record.fragmentShader, a_record.fragmentName.c_str());
+		if (!vertexCompiled || !fragmentCompiled)
+		{
+			glDeleteShader(a_record.vertexShader);
+			glDeleteShader(a_record.fragmentShader);
+			a_record.vertexShader = a_record.fragmentShader = 0;
+			a_record.status = ProgramFailed;
+			--mPendingPrograms;
+			return;
+		}
+		a_record.program = submitProgram(a_record.vertexShader, a_record.fragmentShader, a_record.cacheKey != 0);
+		a_record.status = ProgramLinking;
+	}
+	if (a_record.status == ProgramLinking)
+	{
+		if (poll)
+		{
+			int linkDone = GL_FALSE;
+			glGetProgramiv(a_record.program, GL_COMPLETION_STATUS_KHR, &linkDone);
+			if (linkDone == GL_FALSE) { return; }
+		}
+		bool linked = checkProgramLinked(a_record.program);
+		// The program keeps what it needs, the shader objects were only needed to link it
+		glDetachShader(a_record.program, a_record.vertexShader);
+		glDetachShader(a_record.program, a_record.fragmentShader);
+		glDeleteShader(a_record.vertexShader);
+		glDeleteShader(a_record.fragmentShader);
+		a_record.vertexShader = a_record.fragmentShader = 0;
+		--mPendingPrograms;
+		if (!linked)
+		{
+			glDeleteProgram(a_record.program);
+			a_record.program = 0;
+			a_record.status = ProgramFailed;
+			return;
+		}
+		a_record.status = ProgramReady;
+		if (a_record.cacheKey != 0)
+		{
+			saveCachedProgram(a_record.cacheKey, a_record.program);
+		}
+	}
+}
+
+void ShaderUtil::initialiseDriverInfo()
+{
+	// Work out once whether binaries can be cached at all, and which driver they would belong to
+	int formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	mBinaryCacheSupported = formatCount > 0;
+	const char* driverStrings[3] = { (const char*)glGetString(GL_VENDOR), (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION) };
+	mDriverHash = 1;
+	for (const char* driverString : driverStrings)
+	{
+		if (driverString != nullptr)
+		{
+			mDriverHash = Utilities::hashBuffer(driverString, strlen(driverString), mDriverHash);
+		}
+	}
+	mParallelCompile = GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+	if (GLAD_GL_KHR_parallel_shader_compile)
+	{
+		// 0xFFFFFFFF lets the driver pick how many compiler threads to use
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	}
+	else if (GLAD_GL_ARB_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+	}
+	std::cout << "Parallel shader compile " << (mParallelCompile ? "available" : "unavailable")
+		<< ", program binaries " << (mBinaryCacheSupported ? "available" : "unavailable") << std::endl;
+}
+
+// Insert the defines after the #version directive, which GLSL requires to come first
+static std::string injectDefines(const std::string& a_source, const char* a_defines)
+{
+	std::string source(a_source);
+	if (a_defines[0] == '\0') { return source; }
+	size_t insertAt = 0;
+	unsigned int versionLine = 0;
+	// Only a directive at the start of a line counts, comments above it are free to mention #version
+	size_t versionPos = source.find("#version");
+	while (versionPos != std::string::npos)
+	{
+		size_t lineStart = source.find_last_of('\n', versionPos);
+		lineStart = (lineStart == std::string::npos) ? 0 : lineStart + 1;
+		if (source.find_first_not_of(" \t", lineStart) == versionPos) { break; }
+		versionPos = source.find("#version", versionPos + 1);
+	}
+	if (versionPos != std::string::npos)
+	{
+		size_t lineEnd = source.find('\n', versionPos);
+		insertAt = (lineEnd == std::string::npos) ? source.size() : lineEnd + 1;
+		versionLine = (unsigned int)std::count(source.begin(), source.begin() + versionPos, '\n') + 1;
+	}
+	std::string defines(a_defines);
+	if (defines.back() != '\n') { defines += '\n'; }
+	// Put the line numbers back so compile errors still point at the right line of the file
+	defines += "#line " + std::to_string(versionLine + 1) + "\n";
+	source.insert(insertAt, defines);
+	return source;
+}
+
+// Reads a shader file and splices in any #include "file" lines, include paths are relative to the including file
+static bool expandIncludes(const std::string& a_path, std::string& a_output, unsigned int a_depth)
+{
+	// Deep enough for any sensible include tree, stops a file that includes itself from recursing forever
+	static const unsigned int s_maxIncludeDepth = 16;
+	if (a_depth > s_maxIncludeDepth)
+	{
+		std::cout << "Shader includes nested too deeply at: " << a_path << std::endl;
+		return false;
+	}
+	char* file = Utilities::fileToBuffer(a_path.c_str());
+	if (file == nullptr)
+	{
+		std::cout << "Unable to open shader: " << a_path << std::endl;
+		return false;
+	}
+	std::string text(file);
+	delete[] file;
+
+	size_t slash = a_path.find_last_of("/\\");
+	std::string directory = (slash == std::string::npos) ? std::string() : a_path.substr(0, slash + 1);
+	unsigned int lineNumber = 1;
+	size_t lineStart = 0;
+	while (lineStart < text.size())
+	{
+		size_t lineEnd = text.find('\n', lineStart);
+		if (lineEnd == std::string::npos) { lineEnd = text.size(); }
+		size_t first = text.find_first_not_of(" \t", lineStart);
+		if (first < lineEnd && text.compare(first, 8, "#include") == 0)
+		{
+			size_t open = text.find('"', first + 8);
+			size_t close = (open < lineEnd) ? text.find('"', open + 1) : std::string::npos;
+			if (close >= lineEnd)
+			{
+				std::cout << "Malformed #include in " << a_path << " line " << lineNumber << std::endl;
+				return false;
+			}
+			// Number the included lines from 1 so compile errors point into the included file, then carry on after the #include
+			a_output += "#line 1\n";
+			if (!expandIncludes(directory + text.substr(open + 1, close - open - 1), a_output, a_depth + 1))
+			{
+				return false;
+			}
+			a_output += "\n#line " + std::to_string(lineNumber + 1) + "\n";
+		}
+		else
+		{
+			a_output.append(text, lineStart, lineEnd - lineStart);
+			a_output += '\n';
+		}
+		lineStart = lineEnd + 1;
+		++lineNumber;
+	}
+	return true;
+}
+
+// Full preprocess of one stage: includes are expanded first so the defines land ahead of the included code too
+static bool preprocessShader(const char* a_path, const char* a_defines, std::string& a_source)
+{
+	std::string expanded;
+	if (!expandIncludes(a_path, expanded, 0)) { return false; }
+	a_source = injectDefines(expanded, a_defines);
+	return true;
+}
+
+ProgramHandle ShaderUtil::getProgramVariant(const char* a_vertexFile, const char* a_fragmentFile, unsigned int a_featureMask, const char* const* a_featureNames, unsigned int a_featureCount)
+{
+	MemoryTagScope memoryTag(MemoryStats::Shaders);
+	ShaderUtil* instance = ShaderUtil::GetInstance();
+	unsigned long long key = Utilities::hashBuffer(a_vertexFile, strlen(a_vertexFile));
+	key = Utilities::hashBuffer(a_fragmentFile, strlen(a_fragmentFile), key);
+	key = Utilities::hashBuffer(&a_featureMask, sizeof(a_featureMask), key);
+	auto variantIter = instance->mVariants.find(key);
+	// The handle goes stale if someone deleted the program, in which case it's built again
+	if (variantIter != instance->mVariants.end() && instance->mPrograms.Contains(variantIter->second))
+	{
+		return variantIter->second;
+	}
+	std::string defines;
+	for (unsigned int bit = 0; bit < a_featureCount; ++bit)
+	{
+		if (a_featureMask & (1u << bit))
+		{
+			defines += "#define " + std::string(a_featureNames[bit]) + "\n";
+		}
+	}
+	ProgramHandle program = instance->loadProgramInternal(a_vertexFile, a_fragmentFile, defines.c_str(), false);
+	instance->mVariants[key] = program;
+	return program;
+}
+
+ProgramHandle ShaderUtil::loadProgramInternal(const char* a_vertexFile, const char* a_fragmentFile, const char* a_defines, bool a_block)
+{
+	CPU_PROFILE_SCOPE("Shader Load");
+	MemoryTagScope memoryTag(MemoryStats::Shaders);
+	std::string vertexSource, fragmentSource;
+	if (!preprocessShader(a_vertexFile, a_defines, vertexSource) || !preprocessShader(a_fragmentFile, a_defines, fragmentSource))
+	{
+		std::cout << "Unable to load shader program: " << a_vertexFile << ", " << a_fragmentFile << std::endl;
+		return ProgramHandle();
+	}
+
+	if (mDriverHash == 0)
+	{
+		initialiseDriverInfo();
+	}
+	// The defines are already part of the source text, so hashing the final sources covers them too
+	unsigned long long key = Utilities::hashBuffer(vertexSource.data(), vertexSource.size(), mDriverHash);
+	key = Utilities::hashBuffer(fragmentSource.data(), fragmentSource.size(), key);
+
+	ProgramRecord record = { 0, 0, 0, ProgramCompiling, mBinaryCacheSupported ? key : 0, a_vertexFile, a_fragmentFile };
+	if (mBinaryCacheSupported)
+	{
+		record.program = loadCachedProgram(key);
+		if (record.program != 0)
+		{
+			++mCacheHits;
+			std::cout << "Loaded shader program from cache: " << a_vertexFile << ", " << a_fragmentFile << std::endl;
+			record.status = ProgramReady;
+			return mPrograms.Insert(std::move(record));
+		}
+	}
+	++mCacheMisses;
+
+	// Both stages are submitted before anything is checked so the driver can compile them side by side
+	record.vertexShader = submitShader(vertexSource.c_str(), GL_VERTEX_SHADER);
+	record.fragmentShader = submitShader(fragmentSource.c_str(), GL_FRAGMENT_SHADER);
+	++mPendingPrograms;
+	ProgramHandle handle = mPrograms.Insert(std::move(record));
+	if (a_block)
+	{
+		advanceProgram(*mPrograms.Get(handle), true);
+	}
+	return handle;
+}
+
+// Layout of a cache file, the binary blob follows the header
+typedef struct ProgramBinaryHeader
+{
+	unsigned int magic;
+	unsigned int format;
+	unsigned int length;
+	unsigned int pad;
+	unsigned long long key;
+} ProgramBinaryHeader;
+static const unsigned int s_programBinaryMagic = 0x43425053; // "SPBC"
+static const char* s_shaderCacheDirectory = "shader_cache";
+
+std::string ShaderUtil::getCachePath(unsigned long long a_key) const
+{
+	char filename[32];
+	snprintf(filename, sizeof(filename), "%016llx.bin", a_key);
+	return std::string(s_shaderCacheDirectory) + "/" + filename;
+}
+
+unsigned int ShaderUtil::loadCachedProgram(unsigned long long a_key)
+{
+	std::ifstream file(getCachePath(a_key), std::ios_base::in | std::ios_base::binary);
+	if (!file.is_open()) { return 0; }
+	ProgramBinaryHeader header = {};
+	file.read((char*)&header, sizeof(header));
+	if (!file || header.magic != s_programBinaryMagic || header.key != a_key || header.length == 0) { return 0; }
+	std::vector<char> binary(header.length);
+	file.read(binary.data(), header.length);
+	if (!file) { return 0; }
+
+	unsigned int program = glCreateProgram();
+	{
+		MemoryTagScope driverTag(MemoryStats::Driver);
+		glProgramBinary(program, header.format, binary.data(), (GLsizei)header.length);
+	}
+	// A driver update can reject an old binary even with matching version strings, so the link status decides
+	int success = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (GL_FALSE == success)
+	{
+		std::cout << "Cached shader binary rejected by the driver, recompiling" << std::endl;
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+void ShaderUtil::saveCachedProgram(unsigned long long a_key, unsigned int a_program)
+{
+	int length = 0;
+	glGetProgramiv(a_program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) { return; }
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(a_program, length, &length, &format, binary.data());
+	if (length <= 0) { return; }
+
+	std::error_code error;
+	std::filesystem::create_directories(s_shaderCacheDirectory, error);
+	std::ofstream file(getCachePath(a_key), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Unable to write shader cache file" << std::endl;
+		return;
+	}
+	ProgramBinaryHeader header = { s_programBinaryMagic, format, (unsigned int)length, 0, a_key };
+	file.write((const char*)&header, sizeof(header));
+	file.write(binary.data(), length);
+}
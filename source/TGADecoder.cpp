@@ -0,0 +1,190 @@
+#include "TGADecoder.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define TGA_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// TGA header layout, see the Truevision TGA 2.0 specification
+enum TGAHeader
+{
+	IDLength		= 0,
+	ColourMapType	= 1,
+	ImageType		= 2,
+	Width			= 12,
+	Height			= 14,
+	BitsPerPixel	= 16,
+	Descriptor		= 17,
+
+	HeaderSize		= 18,
+};
+
+enum TGAImageType
+{
+	UncompressedTrueColour	= 2,
+	RLETrueColour			= 10,
+};
+
+// Descriptor bits for the pixel ordering
+static const unsigned char s_rightToLeftBit = 0x10;
+static const unsigned char s_topToBottomBit = 0x20;
+
+static inline unsigned int PackRGBA(const unsigned char* a_bgr, unsigned int a_bytesPerPixel)
+{
+	unsigned int alpha = (a_bytesPerPixel == 4) ? a_bgr[3] : 0xFF;
+	return (unsigned int)a_bgr[2] | ((unsigned int)a_bgr[1] << 8) | ((unsigned int)a_bgr[0] << 16) | (alpha << 24);
+}
+
+// Swizzle a run of BGR(A) pixels into RGBA
+static void SwizzleToRGBA(unsigned int* a_dst, const unsigned char* a_src, unsigned int a_count, unsigned int a_bytesPerPixel)
+{
+	unsigned int i = 0;
+#ifdef TGA_USE_SSE2
+	if (a_bytesPerPixel == 4)
+	{
+		// Swap the B and R bytes of four pixels at a time, G and A stay where they are
+		const __m128i maskGA = _mm_set1_epi32(0xFF00FF00);
+		const __m128i maskLow = _mm_set1_epi32(0x000000FF);
+		for (; i + 4 <= a_count; i += 4)
+		{
+			__m128i bgra = _mm_loadu_si128((const __m128i*)(a_src + i * 4));
+			__m128i ga = _mm_and_si128(bgra, maskGA);
+			__m128i r = _mm_and_si128(_mm_srli_epi32(bgra, 16), maskLow);
+			__m128i b = _mm_slli_epi32(_mm_and_si128(bgra, maskLow), 16);
+			_mm_storeu_si128((__m128i*)(a_dst + i), _mm_or_si128(ga, _mm_or_si128(r, b)));
+		}
+	}
+#endif
+	for (; i < a_count; ++i)
+	{
+		a_dst[i] = PackRGBA(a_src + i * a_bytesPerPixel, a_bytesPerPixel);
+	}
+}
+
+// Fill a run with a single pixel value
+static void FillRun(unsigned int* a_dst, unsigned int a_pixel, unsigned int a_count)
+{
+	unsigned int i = 0;
+#ifdef TGA_USE_SSE2
+	const __m128i pixels = _mm_set1_epi32((int)a_pixel);
+	for (; i + 4 <= a_count; i += 4)
+	{
+		_mm_storeu_si128((__m128i*)(a_dst + i), pixels);
+	}
+#endif
+	for (; i < a_count; ++i)
+	{
+		a_dst[i] = a_pixel;
+	}
+}
+
+unsigned char* TGADecoder::Decode(const unsigned char* a_data, size_t a_size, int& a_width, int& a_height, bool a_flipVertically)
+{
+	if (a_data == nullptr || a_size < HeaderSize) { return nullptr; }
+
+	unsigned char imageType = a_data[ImageType];
+	unsigned int bytesPerPixel = a_data[BitsPerPixel] / 8;
+	unsigned char descriptor = a_data[Descriptor];
+	// Only handle the true colour formats, anything else goes to the generic decoder
+	if (a_data[ColourMapType] != 0 || (imageType != UncompressedTrueColour && imageType != RLETrueColour) ||
+		(bytesPerPixel != 3 && bytesPerPixel != 4) || (descriptor & s_rightToLeftBit))
+	{
+		return nullptr;
+	}
+	unsigned int width = a_data[Width] | (a_data[Width + 1] << 8);
+	unsigned int height = a_data[Height] | (a_data[Height + 1] << 8);
+	if (width == 0 || height == 0) { return nullptr; }
+
+	const unsigned char* src = a_data + HeaderSize + a_data[IDLength];
+	const unsigned char* end = a_data + a_size;
+	if (src > end) { return nullptr; }
+
+	unsigned int* pixels = (unsigned int*)malloc((size_t)width * height * 4);
+	if (pixels == nullptr) { return nullptr; }
+
+	// The file stores rows bottom to top unless the top-to-bottom bit is set. Work out which direction the rows
+	// need to be written in so the output order matches what the caller asked for without a separate flip pass
+	bool fileBottomUp = (descriptor & s_topToBottomBit) == 0;
+	bool reverseRows = (fileBottomUp != a_flipVertically);
+	unsigned int row = 0;
+	unsigned int column = 0;
+	unsigned int* rowStart = pixels + (size_t)(reverseRows ? height - 1 : 0) * width;
+	// Advance the write cursor, RLE packets are allowed to run across row boundaries
+	auto advance = [&](unsigned int a_count)
+	{
+		column += a_count;
+		if (column == width)
+		{
+			column = 0;
+			if (++row < height)
+			{
+				rowStart = pixels + (size_t)(reverseRows ? height - 1 - row : row) * width;
+			}
+		}
+	};
+
+	bool corrupt = false;
+	if (imageType == UncompressedTrueColour)
+	{
+		if ((size_t)(end - src) < (size_t)width * height * bytesPerPixel)
+		{
+			corrupt = true;
+		}
+		else
+		{
+			for (; row < height; ++row, src += (size_t)width * bytesPerPixel)
+			{
+				unsigned int fileRow = reverseRows ? height - 1 - row : row;
+				SwizzleToRGBA(pixels + (size_t)fileRow * width, src, width, bytesPerPixel);
+			}
+		}
+	}
+	else
+	{
+		while (row < height)
+		{
+			if (src >= end) { corrupt = true; break; }
+			unsigned char packet = *src++;
+			unsigned int count = (packet & 0x7F) + 1;
+			if (packet & 0x80)
+			{
+				// Run length packet - one pixel value repeated count times
+				if ((size_t)(end - src) < bytesPerPixel) { corrupt = true; break; }
+				unsigned int pixel = PackRGBA(src, bytesPerPixel);
+				src += bytesPerPixel;
+				while (count > 0 && row < height)
+				{
+					unsigned int span = (count < width - column) ? count : width - column;
+					FillRun(rowStart + column, pixel, span);
+					count -= span;
+					advance(span);
+				}
+			}
+			else
+			{
+				// Raw packet - count literal pixels
+				if ((size_t)(end - src) < (size_t)count * bytesPerPixel) { corrupt = true; break; }
+				while (count > 0 && row < height)
+				{
+					unsigned int span = (count < width - column) ? count : width - column;
+					SwizzleToRGBA(rowStart + column, src, span, bytesPerPixel);
+					src += (size_t)span * bytesPerPixel;
+					count -= span;
+					advance(span);
+				}
+			}
+		}
+	}
+
+	if (corrupt)
+	{
+		free(pixels);
+		return nullptr;
+	}
+	a_width = (int)width;
+	a_height = (int)height;
+	return (unsigned char*)pixels;
+}
@@ -0,0 +1,419 @@
+#include "Telemetry.h"
+#include "FrameStats.h"
+
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+Telemetry* Telemetry::m_instance = nullptr;
+
+// How often the writer wakes up to drain the queue, at 60fps the default queue holds about 17 seconds
+static const std::chrono::milliseconds s_writerPeriod(100);
+
+// JSON/CSV key from a display name, "Draw calls" -> "draw_calls"
+static std::string MakeKey(const char* a_name)
+{
+	std::string key = a_name;
+	for (char& c : key)
+	{
+		c = (c == ' ') ? '_' : (char)tolower((unsigned char)c);
+	}
+	return key;
+}
+
+Telemetry* Telemetry::CreateInstance(const TelemetryConfig& a_config)
+{
+	if (m_instance == nullptr)
+	{
+		Telemetry* telemetry = new Telemetry(a_config);
+		if (!telemetry->Open())
+		{
+			delete telemetry;
+			return nullptr;
+		}
+		m_instance = telemetry;
+		m_instance->m_writer = std::thread(&Telemetry::WriterLoop, m_instance);
+	}
+	return m_instance;
+}
+
+void Telemetry::DestroyInstance()
+{
+	if (m_instance)
+	{
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+Telemetry::Telemetry(const TelemetryConfig& a_config) :
+	m_config(a_config), m_startTime(std::chrono::steady_clock::now()), m_slots(nullptr), m_enqueuePos(0), m_dequeuePos(0),
+	m_dropped(0), m_frameIndex(0), m_lastCounterFrame(0), m_interval(), m_intervalStart(0.0), m_file(nullptr), m_socket(-1),
+	m_lastConnectAttempt(-1.0), m_stopping(false)
+{
+	m_slots = new Slot[QueueCapacity];
+	for (size_t i = 0; i < QueueCapacity; ++i)
+	{
+		m_slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	for (int i = 0; i < RenderCounters::Counter_Count; ++i)
+	{
+		m_counterKeys[i] = MakeKey(RenderCounters::GetName((RenderCounters::Counter)i));
+	}
+	for (int i = 0; i < GpuMemory::Category_Count; ++i)
+	{
+		m_gpuMemoryKeys[i] = MakeKey(GpuMemory::GetCategoryName((GpuMemory::Category)i));
+	}
+}
+
+Telemetry::~Telemetry()
+{
+	if (m_writer.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_stopMutex);
+			m_stopping = true;
+		}
+		m_stopSignal.notify_one();
+		m_writer.join();
+	}
+	CloseOutput();
+	delete[] m_slots;
+	if (m_dropped > 0)
+	{
+		std::cout << "Telemetry dropped " << m_dropped << " records" << std::endl;
+	}
+}
+
+double Telemetry::Now() const
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+#pragma region Producer
+void Telemetry::Push(const Record& a_record)
+{
+	size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		Slot& slot = m_slots[pos & (QueueCapacity - 1)];
+		size_t sequence = slot.sequence.load(std::memory_order_acquire);
+		ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+		if (diff == 0)
+		{
+			if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				slot.record = a_record;
+				slot.sequence.store(pos + 1, std::memory_order_release);
+				return;
+			}
+		}
+		else if (diff < 0)
+		{
+			// The writer is behind, drop rather than hold up the frame
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+		{
+			pos = m_enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void Telemetry::RecordFrame(const TelemetryFrame& a_frame)
+{
+	++m_frameIndex;
+	double now = Now();
+	// The render thread may not have finished a frame since last time, only count each frame's counters once
+	unsigned long long counters[RenderCounters::Counter_Count] = {};
+	unsigned long long counterFrame = RenderCounters::GetFrameIndex();
+	if (counterFrame != m_lastCounterFrame)
+	{
+		RenderCounters::GetLastFrame(counters);
+		m_lastCounterFrame = counterFrame;
+	}
+
+	if (m_config.interval == TelemetryConfig::PerSecond && m_interval.frameCount == 0)
+	{
+		m_intervalStart = now;
+	}
+	// Accumulate into the interval record, per frame mode just sends it every time
+	Record& record = m_interval;
+	record.type = (m_config.interval == TelemetryConfig::PerFrame) ? Record::Frame : Record::Interval;
+	++record.frameCount;
+	record.cpuMs += a_frame.cpuMs;
+	for (int i = 0; i < RenderCounters::Counter_Count; ++i)
+	{
+		record.counters[i] += counters[i];
+	}
+	record.heapAllocations += a_frame.heapAllocations;
+	record.heapLiveBytes = a_frame.heapLiveBytes;
+	if (a_frame.frameArenaBytes > record.frameArenaBytes) { record.frameArenaBytes = a_frame.frameArenaBytes; }
+
+	if (m_config.interval == TelemetryConfig::PerSecond && now - m_intervalStart < 1.0)
+	{
+		return;
+	}
+	record.frame = m_frameIndex;
+	record.time = now;
+	record.cpuMs /= record.frameCount;
+	GpuMemory::GetCategoryBytes(record.gpuMemory);
+	record.gpuMemoryTotal = GpuMemory::GetTotalBytes();
+	if (FrameStats* frameStats = FrameStats::GetInstance())
+	{
+		FrameStats::Summary cpu = frameStats->GetSummary(FrameStats::CpuFrame);
+		FrameStats::Summary gpu = frameStats->GetSummary(FrameStats::GpuFrame);
+		record.gpuMs = gpu.latest;
+		record.cpuP50 = cpu.p50; record.cpuP95 = cpu.p95; record.cpuP99 = cpu.p99; record.cpuMax = cpu.max;
+		record.gpuP50 = gpu.p50; record.gpuP95 = gpu.p95; record.gpuP99 = gpu.p99; record.gpuMax = gpu.max;
+		record.hitches = cpu.hitches;
+	}
+	Push(record);
+	m_interval = Record();
+}
+
+void Telemetry::RecordLoadPhase(const char* a_name, float a_ms)
+{
+	Record record = Record();
+	record.type = Record::LoadPhase;
+	record.frame = m_frameIndex;
+	record.time = Now();
+	record.phase = a_name;
+	record.phaseMs = a_ms;
+	Push(record);
+}
+#pragma endregion Producer
+
+#pragma region Writer
+size_t Telemetry::Drain(std::string& a_buffer)
+{
+	size_t drained = 0;
+	for (;;)
+	{
+		Slot& slot = m_slots[m_dequeuePos & (QueueCapacity - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1) { break; }
+		Format(slot.record, a_buffer);
+		// Hand the slot back to producers for the next lap
+		slot.sequence.store(m_dequeuePos + QueueCapacity, std::memory_order_release);
+		++m_dequeuePos;
+		++drained;
+	}
+	return drained;
+}
+
+void Telemetry::WriterLoop()
+{
+	std::string buffer;
+	bool stopping = false;
+	while (!stopping)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_stopMutex);
+			m_stopSignal.wait_for(lock, s_writerPeriod, [this]() { return m_stopping; });
+			stopping = m_stopping;
+		}
+		buffer.clear();
+		if (Drain(buffer) > 0)
+		{
+			Write(buffer);
+		}
+	}
+}
+
+void Telemetry::Format(const Record& a_record, std::string& a_buffer) const
+{
+	static const char* s_typeNames[] = { "frame", "interval", "load" };
+	char line[512];
+	if (m_config.format == TelemetryConfig::JsonLines)
+	{
+		snprintf(line, sizeof(line), "{\"type\":\"%s\",\"frame\":%llu,\"time\":%.4f", s_typeNames[a_record.type], a_record.frame, a_record.time);
+		a_buffer += line;
+		if (a_record.type == Record::LoadPhase)
+		{
+			snprintf(line, sizeof(line), ",\"phase\":\"%s\",\"ms\":%.3f}\n", a_record.phase, a_record.phaseMs);
+			a_buffer += line;
+			return;
+		}
+		snprintf(line, sizeof(line), ",\"frames\":%u,\"cpu_ms\":%.3f,\"gpu_ms\":%.3f,\"cpu_p50\":%.3f,\"cpu_p95\":%.3f,\"cpu_p99\":%.3f,\"cpu_max\":%.3f"
+			",\"gpu_p50\":%.3f,\"gpu_p95\":%.3f,\"gpu_p99\":%.3f,\"gpu_max\":%.3f,\"hitches\":%u,\"heap_allocations\":%llu,\"heap_live_bytes\":%lld"
+			",\"frame_arena_bytes\":%llu",
+			a_record.frameCount, a_record.cpuMs, a_record.gpuMs, a_record.cpuP50, a_record.cpuP95, a_record.cpuP99, a_record.cpuMax,
+			a_record.gpuP50, a_record.gpuP95, a_record.gpuP99, a_record.gpuMax, a_record.hitches, a_record.heapAllocations,
+			a_record.heapLiveBytes, (unsigned long long)a_record.frameArenaBytes);
+		a_buffer += line;
+		a_buffer += ",\"counters\":{";
+		for (int i = 0; i < RenderCounters::Counter_Count; ++i)
+		{
+			snprintf(line, sizeof(line), "%s\"%s\":%llu", (i > 0) ? "," : "", m_counterKeys[i].c_str(), a_record.counters[i]);
+			a_buffer += line;
+		}
+		a_buffer += "},\"gpu_memory\":{";
+		for (int i = 0; i < GpuMemory::Category_Count; ++i)
+		{
+			snprintf(line, sizeof(line), "\"%s\":%llu,", m_gpuMemoryKeys[i].c_str(), (unsigned long long)a_record.gpuMemory[i]);
+			a_buffer += line;
+		}
+		snprintf(line, sizeof(line), "\"total\":%llu}}\n", (unsigned long long)a_record.gpuMemoryTotal);
+		a_buffer += line;
+		return;
+	}
+
+	// CSV, load phases share the columns and leave the frame ones empty
+	snprintf(line, sizeof(line), "%s,%llu,%.4f,", s_typeNames[a_record.type], a_record.frame, a_record.time);
+	a_buffer += line;
+	if (a_record.type == Record::LoadPhase)
+	{
+		a_buffer.append(12 + RenderCounters::Counter_Count + 3 + GpuMemory::Category_Count + 1, ',');
+		snprintf(line, sizeof(line), "%s,%.3f\n", a_record.phase, a_record.phaseMs);
+		a_buffer += line;
+		return;
+	}
+	snprintf(line, sizeof(line), "%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%u,",
+		a_record.frameCount, a_record.cpuMs, a_record.gpuMs, a_record.cpuP50, a_record.cpuP95, a_record.cpuP99, a_record.cpuMax,
+		a_record.gpuP50, a_record.gpuP95, a_record.gpuP99, a_record.gpuMax, a_record.hitches);
+	a_buffer += line;
+	for (int i = 0; i < RenderCounters::Counter_Count; ++i)
+	{
+		snprintf(line, sizeof(line), "%llu,", a_record.counters[i]);
+		a_buffer += line;
+	}
+	snprintf(line, sizeof(line), "%llu,%lld,%llu,", a_record.heapAllocations, a_record.heapLiveBytes, (unsigned long long)a_record.frameArenaBytes);
+	a_buffer += line;
+	for (int i = 0; i < GpuMemory::Category_Count; ++i)
+	{
+		snprintf(line, sizeof(line), "%llu,", (unsigned long long)a_record.gpuMemory[i]);
+		a_buffer += line;
+	}
+	snprintf(line, sizeof(line), "%llu,,\n", (unsigned long long)a_record.gpuMemoryTotal);
+	a_buffer += line;
+}
+#pragma endregion Writer
+
+#pragma region Output
+bool Telemetry::Open()
+{
+	if (!m_config.socketPath.empty())
+	{
+#ifdef _WIN32
+		std::cout << "Telemetry sockets aren't supported on Windows, use a file" << std::endl;
+		return false;
+#else
+		// The listener may not be up yet, the writer keeps trying to connect
+		if (!ConnectSocket())
+		{
+			std::cout << "Telemetry socket " << m_config.socketPath << " not available yet, will retry" << std::endl;
+		}
+		return true;
+#endif
+	}
+	m_file = fopen(m_config.path.c_str(), "ab");
+	if (m_file == nullptr)
+	{
+		std::cout << "Unable to open telemetry file: " << m_config.path << std::endl;
+		return false;
+	}
+	// New or empty CSV files get a header so columns can be found by name
+	fseek(m_file, 0, SEEK_END);
+	if (m_config.format == TelemetryConfig::Csv && ftell(m_file) == 0)
+	{
+		std::string header = "type,frame,time,frames,cpu_ms,gpu_ms,cpu_p50,cpu_p95,cpu_p99,cpu_max,gpu_p50,gpu_p95,gpu_p99,gpu_max,hitches,";
+		for (int i = 0; i < RenderCounters::Counter_Count; ++i)
+		{
+			header += m_counterKeys[i] + ",";
+		}
+		header += "heap_allocations,heap_live_bytes,frame_arena_bytes,";
+		for (int i = 0; i < GpuMemory::Category_Count; ++i)
+		{
+			header += "gpu_" + m_gpuMemoryKeys[i] + "_bytes,";
+		}
+		header += "gpu_total_bytes,phase,phase_ms\n";
+		fwrite(header.data(), 1, header.size(), m_file);
+	}
+	std::cout << "Writing telemetry to " << m_config.path << std::endl;
+	return true;
+}
+
+bool Telemetry::ConnectSocket()
+{
+#ifdef _WIN32
+	return false;
+#else
+	m_lastConnectAttempt = Now();
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (m_config.socketPath.size() >= sizeof(address.sun_path)) { return false; }
+	strncpy(address.sun_path, m_config.socketPath.c_str(), sizeof(address.sun_path) - 1);
+	m_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_socket < 0) { return false; }
+	if (connect(m_socket, (sockaddr*)&address, sizeof(address)) != 0)
+	{
+		close(m_socket);
+		m_socket = -1;
+		return false;
+	}
+	return true;
+#endif
+}
+
+void Telemetry::Write(const std::string& a_buffer)
+{
+	if (m_file)
+	{
+		fwrite(a_buffer.data(), 1, a_buffer.size(), m_file);
+		// Flush each batch so a scraper tailing the file sees records within a writer period
+		fflush(m_file);
+		return;
+	}
+#ifndef _WIN32
+	if (m_socket < 0)
+	{
+		// Don't hammer connect while nobody is listening, whatever was drained meanwhile is lost
+		if (Now() - m_lastConnectAttempt < 1.0 || !ConnectSocket())
+		{
+			return;
+		}
+	}
+	size_t sent = 0;
+	while (sent < a_buffer.size())
+	{
+#ifdef MSG_NOSIGNAL
+		ssize_t result = send(m_socket, a_buffer.data() + sent, a_buffer.size() - sent, MSG_NOSIGNAL);
+#else
+		ssize_t result = send(m_socket, a_buffer.data() + sent, a_buffer.size() - sent, 0);
+#endif
+		if (result <= 0)
+		{
+			// The reader went away, reconnect on a later batch
+			close(m_socket);
+			m_socket = -1;
+			return;
+		}
+		sent += (size_t)result;
+	}
+#endif
+}
+
+void Telemetry::CloseOutput()
+{
+	if (m_file)
+	{
+		fclose(m_file);
+		m_file = nullptr;
+	}
+#ifndef _WIN32
+	if (m_socket >= 0)
+	{
+		close(m_socket);
+		m_socket = -1;
+	}
+#endif
+}
+#pragma endregion Output
@@ -1,10 +1,19 @@
 #include "Texture.h"
+#include "MappedFile.h"
+#include "TGADecoder.h"
+#include "CpuProfiler.h"
+#include "RenderCounters.h"
+#include "GpuMemory.h"
+#include "JobSystem.h"
+#include "MemoryStats.h"
 #include <stb_image.h>
 #include <iostream>
+#include <cstring>
+#include <cctype>
 #include <glad/glad.h>
 
 Texture::Texture() :
-	m_filename(), m_width(0), m_height(0), m_textureID(0)
+	m_filename(), m_width(0), m_height(0), m_textureID(0), m_layerCount(1), m_cubeMap(false)
 {
 }
 
@@ -13,11 +22,62 @@ Texture::~Texture()
 	unload();
 }
 
-bool Texture::Load(std::string a_filepath)
+bool Texture::Load(std::string a_filepath, bool a_sRGB)
 {
-	int width = 0, height = 0, channels = 0;
-	stbi_set_flip_vertically_on_load(true);
-	unsigned char* imageData = stbi_load(a_filepath.c_str(), &width, &height, &channels, 4);
+	MappedFile file;
+	if (file.Open(a_filepath.c_str()))
+	{
+		return LoadFromMemory(a_filepath, file.GetData(), file.GetSize(), a_sRGB);
+	}
+	std::cout << "Failed to open Image File: " << a_filepath << std::endl;
+	return false;
+}
+
+// Case insensitive test of a filename's extension
+static bool HasExtension(const std::string& a_filename, const char* a_extension)
+{
+	size_t extensionLength = strlen(a_extension);
+	if (a_filename.size() < extensionLength) { return false; }
+	for (size_t i = 0; i < extensionLength; ++i)
+	{
+		if (tolower((unsigned char)a_filename[a_filename.size() - extensionLength + i]) != a_extension[i]) { return false; }
+	}
+	return true;
+}
+
+unsigned char* Texture::DecodeImage(const std::string& a_filename, const unsigned char* a_data, size_t a_size, int& a_width, int& a_height, bool a_flipVertically)
+{
+	CPU_PROFILE_SCOPE("Texture Decode");
+	if (HasExtension(a_filename, ".tga"))
+	{
+		// Model textures are nearly all TGA, decode those directly from the file bytes
+		unsigned char* pixels = TGADecoder::Decode(a_data, a_size, a_width, a_height, a_flipVertically);
+		if (pixels != nullptr) { return pixels; }
+	}
+	int channels = 0;
+	// stb's flip flag is global state, use the per thread variant so images can be decoded on any thread
+	stbi_set_flip_vertically_on_load_thread(a_flipVertically);
+	return stbi_load_from_memory(a_data, (int)a_size, &a_width, &a_height, &channels, 4);
+}
+
+void Texture::FreeImageData(unsigned char* a_pixels)
+{
+	// stb_image and TGADecoder both allocate with malloc, so one release path covers both
+	stbi_image_free(a_pixels);
+}
+
+// Number of mip levels needed to take the largest dimension down to a single texel
+static int MipLevelCount(unsigned int a_width, unsigned int a_height)
+{
+	int mipLevels = 1;
+	for (unsigned int size = (a_width > a_height ? a_width : a_height); size > 1; size >>= 1) { ++mipLevels; }
+	return mipLevels;
+}
+
+bool Texture::LoadFromMemory(const std::string& a_filepath, const unsigned char* a_data, size_t a_size, bool a_sRGB)
+{
+	int width = 0, height = 0;
+	unsigned char* imageData = DecodeImage(a_filepath, a_data, a_size, width, height, true);
 	// converting the loaded image data into an OpenGL format -> sending to the GPU
 	if (imageData != nullptr)
 	{
@@ -30,10 +90,18 @@ bool Texture::Load(std::string a_filepath)
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);		
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);		// specify some parameters such as how the texture will wrap on its UV (ST in GL speak) axis
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData); // Filling the texture buffer that we created with pixel data
-		glGenerateMipmap(GL_TEXTURE_2D);
+		glTexImage2D(GL_TEXTURE_2D, 0, a_sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData); // Filling the texture buffer that we created with pixel data
+		{
+			// llvmpipe JITs its mipmap filter on first use and keeps the code until exit
+			MemoryTagScope driverTag(MemoryStats::Driver);
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
 		glBindTexture(GL_TEXTURE_2D, 0);
-		stbi_image_free(imageData);
+		GpuMemory::RecordTexture(m_textureID, GpuMemory::Textures, a_sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8, width, height, 1,
+			MipLevelCount(width, height), a_filepath.c_str());
+		RENDER_COUNT(TextureUploads, 1);
+		RENDER_COUNT(TextureBytesUploaded, (unsigned long long)width * height * 4);
+		FreeImageData(imageData);
 		std::cout << "Successfully loaded Image File: " << a_filepath << std::endl;
 		return true;
 	}
@@ -43,41 +111,156 @@ bool Texture::Load(std::string a_filepath)
 
 unsigned int Texture::LoadCubeMap(std::vector<std::string>a_filenames, unsigned int* cubemap_face_id)
 {
-	glGenTextures(1, &m_textureID);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_textureID);
-
-	int width, height, nrChannels;
+	MappedFile faces[6];
+	std::string name;
 	for (unsigned int i = 0; i < 6; i++)
+	{
+		if (!faces[i].Open(a_filenames[i].c_str()))
+		{
+			std::cout << "Cubemap tex failed to load at path: " << a_filenames[i] << std::endl;
+		}
+		name += (i > 0 ? ";" : "") + a_filenames[i];
+	}
+	LoadCubeMapFromMemory(name, faces, cubemap_face_id);
+	return m_textureID;
+}
+
+// Cubemap names are the six face filenames joined with ';'
+static std::vector<std::string> SplitFaceNames(const std::string& a_name)
+{
+	std::vector<std::string> names;
+	size_t start = 0;
+	for (size_t end = a_name.find(';'); end != std::string::npos; end = a_name.find(';', start))
+	{
+		names.push_back(a_name.substr(start, end - start));
+		start = end + 1;
+	}
+	names.push_back(a_name.substr(start));
+	return names;
+}
+
+bool Texture::LoadCubeMapFromMemory(const std::string& a_name, const MappedFile* a_faces, const unsigned int* cubemap_face_id)
+{
+	// Decoding is the expensive part so each face is decoded as its own job
+	struct DecodedFace
 	{
 		unsigned char* data;
-		stbi_set_flip_vertically_on_load(false);
-		data = stbi_load(a_filenames[i].c_str(), &width, &height, &nrChannels, 4);
-		if (data != nullptr)
+		int width;
+		int height;
+	};
+	DecodedFace decodedFaces[6] = {};
+	std::vector<std::string> faceNames = SplitFaceNames(a_name);
+	auto decodeFaces = [a_faces, &faceNames, &decodedFaces](size_t a_begin, size_t a_end)
+	{
+		for (size_t i = a_begin; i < a_end; ++i)
 		{
-			m_width = width;
-			m_height = height;
-			glTexImage2D(cubemap_face_id[i], 0, GL_RGBA , width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-			stbi_image_free(data);
-			std::cout << "Successfully loaded image file" << a_filenames[i] << std::endl;
+			if (a_faces[i].IsOpen())
+			{
+				std::string faceName = (i < faceNames.size()) ? faceNames[i] : std::string();
+				decodedFaces[i].data = DecodeImage(faceName, a_faces[i].GetData(), a_faces[i].GetSize(), decodedFaces[i].width, decodedFaces[i].height, false);
+			}
 		}
-		else
+	};
+	if (JobSystem* jobs = JobSystem::GetInstance())
+	{
+		jobs->ParallelFor(6, 1, decodeFaces);
+	}
+	else
+	{
+		decodeFaces(0, 6);
+	}
+	bool success = true;
+	for (unsigned int i = 0; i < 6; i++)
+	{
+		// All faces of a cubemap must be square and the same size to share one storage allocation
+		if (decodedFaces[i].data == nullptr || decodedFaces[i].width != decodedFaces[0].width || decodedFaces[i].height != decodedFaces[0].height)
 		{
-			std::cout << "Cubemap tex failed to load at path: " << a_filenames[i] << std::endl;
-			stbi_image_free(data);
+			std::cout << "Cubemap tex failed to load face " << i << " of: " << a_name << std::endl;
+			success = false;
 		}
 	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	// glTexStorage2D rejects non square cubemaps and every upload after it would then fail silently
+	if (success && decodedFaces[0].width != decodedFaces[0].height)
+	{
+		std::cout << "Cubemap faces must be square (" << decodedFaces[0].width << "x" << decodedFaces[0].height << "): " << a_name << std::endl;
+		success = false;
+	}
 
-	return m_textureID;
+	if (success)
+	{
+		m_filename = a_name;
+		m_width = decodedFaces[0].width;
+		m_height = decodedFaces[0].height;
+		m_cubeMap = true;
+		m_layerCount = 6;
+		// Allocate every face and mip level in one immutable allocation, skybox faces are colour data so stored as sRGB
+		glGenTextures(1, &m_textureID);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, m_textureID);
+		glTexStorage2D(GL_TEXTURE_CUBE_MAP, MipLevelCount(m_width, m_height), GL_SRGB8_ALPHA8, m_width, m_height);
+		for (unsigned int i = 0; i < 6; i++)
+		{
+			glTexSubImage2D(cubemap_face_id[i], 0, 0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, decodedFaces[i].data);
+		}
+		RENDER_COUNT(TextureUploads, 6);
+		RENDER_COUNT(TextureBytesUploaded, 6ull * m_width * m_height * 4);
+		{
+			MemoryTagScope driverTag(MemoryStats::Driver);
+			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+		}
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+		GpuMemory::RecordTexture(m_textureID, GpuMemory::Cubemaps, GL_SRGB8_ALPHA8, m_width, m_height, 6, MipLevelCount(m_width, m_height), a_name.c_str());
+		std::cout << "Successfully loaded cubemap: " << a_name << std::endl;
+	}
+	for (unsigned int i = 0; i < 6; i++)
+	{
+		FreeImageData(decodedFaces[i].data);
+	}
+	return success;
+}
+
+bool Texture::LoadArray(const std::string& a_name, unsigned int a_width, unsigned int a_height, const std::vector<const unsigned char*>& a_layers, bool a_sRGB)
+{
+	if (a_layers.empty() || a_width == 0 || a_height == 0) { return false; }
+	m_filename = a_name;
+	m_width = a_width;
+	m_height = a_height;
+	m_layerCount = (unsigned int)a_layers.size();
+	// One immutable allocation holds every layer and its mip chain
+	glGenTextures(1, &m_textureID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureID);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, MipLevelCount(m_width, m_height), a_sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8, m_width, m_height, m_layerCount);
+	for (unsigned int layer = 0; layer < m_layerCount; ++layer)
+	{
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_width, m_height, 1, GL_RGBA, GL_UNSIGNED_BYTE, a_layers[layer]);
+	}
+	RENDER_COUNT(TextureUploads, m_layerCount);
+	RENDER_COUNT(TextureBytesUploaded, (unsigned long long)m_layerCount * m_width * m_height * 4);
+	{
+		MemoryTagScope driverTag(MemoryStats::Driver);
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	}
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	GpuMemory::RecordTexture(m_textureID, GpuMemory::TextureArrays, a_sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8, m_width, m_height, m_layerCount,
+		MipLevelCount(m_width, m_height), a_name.c_str());
+	std::cout << "Successfully built texture array (" << m_width << "x" << m_height << ", " << m_layerCount << " layers)" << std::endl;
+	return true;
 }
 
 void Texture::unload()
 {
+	if (m_textureID == 0) { return; }
+	GpuMemory::ReleaseTexture(m_textureID);
 	glDeleteTextures(1, &m_textureID);
+	m_textureID = 0;
 }
 			
 		
@@ -1,5 +1,11 @@
 #include "TextureManager.h"
 #include "Texture.h"
+#include "MappedFile.h"
+#include "Utilities.h"
+#include "MemoryStats.h"
+
+#include <glad/glad.h>
+#include <iostream>
 
 // Set up a static pointer for Singleton object
 TextureManager* TextureManager::m_instance = nullptr;
@@ -30,82 +36,299 @@ void TextureManager::DestroyInstance()
 	}
 }
 
-TextureManager::TextureManager() : m_pTextureMap()
+TextureManager::TextureManager() : m_textures(), m_pTextureMap(), m_pathMap(), m_bytesSaved(0)
 {
 }
 
 TextureManager::~TextureManager()
 {
+	// Anything not released by now is still owned here, free it rather than leaking the Texture and its GL object
+	if (!m_textures.Empty())
+	{
+		std::cout << "TextureManager destroyed with " << m_textures.Size() << " texture(s) still referenced" << std::endl;
+	}
+	for (TextureRef& texRef : m_textures)
+	{
+		delete texRef.pTexure;
+	}
+	m_textures.Clear();
 	m_pTextureMap.clear();
+	m_pathMap.clear();
+}
+
+// Estimate of the GPU memory used by an RGBA8 texture including its mip chain
+static unsigned long long TextureBytes(const Texture* a_pTexture)
+{
+	unsigned int width = 0, height = 0;
+	a_pTexture->GetDimensions(width, height);
+	return ((unsigned long long)width * height * 4 * 4 * a_pTexture->GetLayerCount()) / 3;
+}
+
+TextureHandle TextureManager::AddTexture(Texture* a_pTexture, unsigned long long a_contentHash, unsigned int a_refCount)
+{
+	TextureRef texRef = { a_pTexture, a_refCount, a_contentHash, {} };
+	TextureHandle texture = m_textures.Insert(std::move(texRef));
+	m_pTextureMap[a_contentHash] = texture;
+	return texture;
+}
+
+void TextureManager::AddPath(TextureHandle a_texture, const PathKey& a_path)
+{
+	m_pathMap[a_path] = a_texture;
+	m_textures.Get(a_texture)->paths.push_back(a_path);
 }
 
 //Uses an std map as a texture directory and reference counting
-unsigned int TextureManager::LoadTexture(const char* a_filename)
+TextureHandle TextureManager::LoadTexture(const char* a_filename, bool a_sRGB)
 {
+	MemoryTagScope memoryTag(MemoryStats::Textures);
 	if (a_filename != nullptr)
 	{
-		auto dictionaryIter = m_pTextureMap.find(a_filename);
+		TextureHandle texture = FindTextureByPath(a_filename, a_sRGB);
+		if (texture.IsValid())
+		{
+			// Texture is already in map, increment the ref and return its handle
+			++m_textures.Get(texture)->refCount;
+			return texture;
+		}
+		// Path has not been seen before, hash the file contents to see if we already hold an identical texture
+		MappedFile file;
+		if (!file.Open(a_filename))
+		{
+			std::cout << "Failed to open Image File: " << a_filename << std::endl;
+			return TextureHandle();
+		}
+		// The colour space seeds the hash so sRGB and linear copies of the same file never share a texture
+		unsigned long long contentHash = Utilities::hashBuffer(file.GetData(), file.GetSize(), a_sRGB ? 1 : 0);
+		auto dictionaryIter = m_pTextureMap.find(contentHash);
 		if (dictionaryIter != m_pTextureMap.end())
 		{
-			// Texture is already in map, increment the ref and return the texture ID
-			TextureRef& texRef = (TextureRef&)(dictionaryIter->second);
+			// Duplicate of a loaded texture under a different name, share the existing GL texture
+			texture = dictionaryIter->second;
+			TextureRef& texRef = *m_textures.Get(texture);
 			++texRef.refCount;
-			return texRef.pTexure->GetTextureID();
+			m_bytesSaved += TextureBytes(texRef.pTexure);
+			std::cout << "Image File: " << a_filename << " is a duplicate of " << texRef.pTexure->GetFileName()
+				<< " (" << m_bytesSaved / 1024 << " KB saved)" << std::endl;
+			AddPath(texture, std::make_pair(std::string(a_filename), a_sRGB));
+			return texture;
+		}
+		//texture is not in dictionary load in from the mapped file
+		Texture* pTexture = new Texture();
+		if (pTexture->LoadFromMemory(a_filename, file.GetData(), file.GetSize(), a_sRGB))
+		{
+			//successful load
+			texture = AddTexture(pTexture, contentHash, 1);
+			AddPath(texture, std::make_pair(std::string(a_filename), a_sRGB));
+			return texture;
+		}
+		else
+		{
+			delete pTexture;
+			return TextureHandle();
+		}
+	} return TextureHandle();	
+}
+
+TextureHandle TextureManager::LoadCubeMap(const std::vector<std::string>& a_faceFilenames)
+{
+	MemoryTagScope memoryTag(MemoryStats::Textures);
+	if (a_faceFilenames.size() != 6) { return TextureHandle(); }
+	// The cubemap is looked up by its face list so repeated loads of the same skybox are free
+	std::string name;
+	for (unsigned int i = 0; i < 6; ++i)
+	{
+		name += (i > 0 ? ";" : "") + a_faceFilenames[i];
+	}
+	TextureHandle texture = FindTextureByPath(name.c_str(), true);
+	if (texture.IsValid())
+	{
+		++m_textures.Get(texture)->refCount;
+		return texture;
+	}
+	// Chain the face hashes together so the content key covers all six faces in order
+	MappedFile faces[6];
+	unsigned long long contentHash = 1;
+	for (unsigned int i = 0; i < 6; ++i)
+	{
+		if (!faces[i].Open(a_faceFilenames[i].c_str()))
+		{
+			std::cout << "Cubemap tex failed to load at path: " << a_faceFilenames[i] << std::endl;
+			return TextureHandle();
+		}
+		contentHash = Utilities::hashBuffer(faces[i].GetData(), faces[i].GetSize(), contentHash);
+	}
+	auto dictionaryIter = m_pTextureMap.find(contentHash);
+	if (dictionaryIter != m_pTextureMap.end())
+	{
+		texture = dictionaryIter->second;
+		TextureRef& texRef = *m_textures.Get(texture);
+		++texRef.refCount;
+		m_bytesSaved += TextureBytes(texRef.pTexure);
+		AddPath(texture, std::make_pair(name, true));
+		return texture;
+	}
+	static const unsigned int cubemapFaceIDs[6] = { GL_TEXTURE_CUBE_MAP_POSITIVE_X,  GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
+													GL_TEXTURE_CUBE_MAP_POSITIVE_Y,  GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
+													GL_TEXTURE_CUBE_MAP_POSITIVE_Z,  GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, };
+	Texture* pTexture = new Texture();
+	if (pTexture->LoadCubeMapFromMemory(name, faces, cubemapFaceIDs))
+	{
+		texture = AddTexture(pTexture, contentHash, 1);
+		AddPath(texture, std::make_pair(name, true));
+		return texture;
+	}
+	delete pTexture;
+	return TextureHandle();
+}
+
+void TextureManager::LoadTextureArrays(const std::vector<std::string>& a_filenames, std::vector<TextureArraySlot>& a_slots, bool a_sRGB)
+{
+	MemoryTagScope memoryTag(MemoryStats::Textures);
+	// Decoded image, shared by every filename with the same contents
+	typedef struct DecodedImage
+	{
+		unsigned long long contentHash;
+		unsigned char* pixels;
+		int width;
+		int height;
+	} DecodedImage;
+	std::vector<DecodedImage> images;
+	std::vector<int> imageForFile(a_filenames.size(), -1);
+	std::map<unsigned long long, int> imageByHash;
+	for (size_t i = 0; i < a_filenames.size(); ++i)
+	{
+		if (a_filenames[i].empty()) { continue; }
+		MappedFile file;
+		if (!file.Open(a_filenames[i].c_str()))
+		{
+			std::cout << "Failed to open Image File: " << a_filenames[i] << std::endl;
+			continue;
+		}
+		unsigned long long contentHash = Utilities::hashBuffer(file.GetData(), file.GetSize(), a_sRGB ? 1 : 0);
+		auto hashIter = imageByHash.find(contentHash);
+		if (hashIter != imageByHash.end())
+		{
+			imageForFile[i] = hashIter->second;
+			continue;
+		}
+		DecodedImage image = { contentHash, nullptr, 0, 0 };
+		image.pixels = Texture::DecodeImage(a_filenames[i], file.GetData(), file.GetSize(), image.width, image.height, true);
+		if (image.pixels == nullptr)
+		{
+			std::cout << "Unable to decode image: " << a_filenames[i] << std::endl;
+			continue;
+		}
+		imageByHash[contentHash] = (int)images.size();
+		imageForFile[i] = (int)images.size();
+		images.push_back(image);
+	}
+
+	// Layers of an array must share dimensions, so bucket the images by size and build one array per bucket
+	std::map<std::pair<int, int>, std::vector<int>> buckets;
+	for (int i = 0; i < (int)images.size(); ++i)
+	{
+		buckets[std::make_pair(images[i].width, images[i].height)].push_back(i);
+	}
+	std::vector<TextureArraySlot> imageSlots(images.size(), TextureArraySlot{ TextureHandle(), 0 });
+	for (auto bucketIter = buckets.begin(); bucketIter != buckets.end(); ++bucketIter)
+	{
+		const std::vector<int>& members = bucketIter->second;
+		std::vector<const unsigned char*> layers;
+		unsigned long long arrayHash = a_sRGB ? 1 : 0;
+		for (size_t layer = 0; layer < members.size(); ++layer)
+		{
+			layers.push_back(images[members[layer]].pixels);
+			arrayHash = Utilities::hashBuffer(&images[members[layer]].contentHash, sizeof(unsigned long long), arrayHash);
+		}
+		TextureHandle texture;
+		auto dictionaryIter = m_pTextureMap.find(arrayHash);
+		if (dictionaryIter != m_pTextureMap.end())
+		{
+			texture = dictionaryIter->second;
 		}
 		else
 		{
-			//texture is not in dictionary load in from file
 			Texture* pTexture = new Texture();
-			if (pTexture->Load(a_filename))
+			std::string name = "TextureArray_" + std::to_string(bucketIter->first.first) + "x" + std::to_string(bucketIter->first.second);
+			if (pTexture->LoadArray(name, bucketIter->first.first, bucketIter->first.second, layers, a_sRGB))
 			{
-				//successful load
-				TextureRef texRef = { pTexture, 1 };
-				m_pTextureMap[a_filename] = texRef;
-				return pTexture->GetTextureID();
+				// Reference count is taken per slot below
+				texture = AddTexture(pTexture, arrayHash, 0);
 			}
 			else
 			{
 				delete pTexture;
-				return 0;
+				continue;
 			}
 		}
-	} return 0;	
+		for (size_t layer = 0; layer < members.size(); ++layer)
+		{
+			imageSlots[members[layer]].texture = texture;
+			imageSlots[members[layer]].layer = (unsigned int)layer;
+		}
+	}
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		Texture::FreeImageData(images[i].pixels);
+	}
+
+	a_slots.assign(a_filenames.size(), TextureArraySlot{ TextureHandle(), 0 });
+	for (size_t i = 0; i < a_filenames.size(); ++i)
+	{
+		int image = imageForFile[i];
+		if (image < 0 || !imageSlots[image].texture.IsValid()) { continue; }
+		// Each slot holds a reference so the array is freed once every material has released it
+		a_slots[i] = imageSlots[image];
+		++m_textures.Get(imageSlots[image].texture)->refCount;
+	}
 }
 
-void TextureManager::ReleaseTexture(unsigned int a_texture)
+void TextureManager::ReleaseTexture(TextureHandle a_texture)
 {
-	for (auto dictionaryIter = m_pTextureMap.begin();
-		dictionaryIter != m_pTextureMap.end(); ++dictionaryIter)
+	TextureRef* pTexRef = m_textures.Get(a_texture);
+	if (pTexRef == nullptr) { return; }
+	// Pre decrement will happen prior to call to ==
+	if (--pTexRef->refCount == 0)
 	{
-		TextureRef& texRef = (TextureRef&)(dictionaryIter->second);
-		if (a_texture == texRef.pTexure->GetTextureID())
+		// Remove every filename that pointed at this texture's contents
+		for (const PathKey& path : pTexRef->paths)
 		{
-			// Pre decrement will happen prior to call to ==
-			if (--texRef.refCount == 0)
-			{
-				delete texRef.pTexure;
-				texRef.pTexure = nullptr;
-				m_pTextureMap.erase(dictionaryIter);
-				break;
-			}
+			m_pathMap.erase(path);
 		}
+		m_pTextureMap.erase(pTexRef->contentHash);
+		delete pTexRef->pTexure;
+		m_textures.Remove(a_texture);
 	}
 }
 
-bool TextureManager::TextureExists(const char* a_filename)
+TextureHandle TextureManager::FindTextureByPath(const char* a_filename, bool a_sRGB)
 {
-	auto dictIter = m_pTextureMap.find(a_filename);
-	return (dictIter != m_pTextureMap.end());
+	auto pathIter = m_pathMap.find(std::make_pair(std::string(a_filename), a_sRGB));
+	if (pathIter != m_pathMap.end())
+	{
+		return pathIter->second;
+	}
+	return TextureHandle();
+}
+
+bool TextureManager::TextureExists(const char* a_filename, bool a_sRGB)
+{
+	return FindTextureByPath(a_filename, a_sRGB).IsValid();
 }
 
-unsigned int TextureManager::GetTexture(const char* a_filename)
+TextureHandle TextureManager::GetTexture(const char* a_filename, bool a_sRGB)
 {
-	auto dictIter = m_pTextureMap.find(a_filename);
-	if (dictIter != m_pTextureMap.end())
+	TextureHandle texture = FindTextureByPath(a_filename, a_sRGB);
+	if (texture.IsValid())
 	{
-		TextureRef& texRef = (TextureRef&)(dictIter->second);
-		texRef.refCount++;
-		return texRef.pTexure->GetTextureID();
+		m_textures.Get(texture)->refCount++;
 	}
-	return 0;
-}
\ No newline at end of file
+	return texture;
+}
+
+unsigned int TextureManager::GetTextureID(TextureHandle a_texture) const
+{
+	const TextureRef* pTexRef = m_textures.Get(a_texture);
+	return (pTexRef != nullptr) ? pTexRef->pTexure->GetTextureID() : 0;
+}
@@ -1,7 +1,11 @@
 #include <glad/glad.h>
+#ifndef RENDER_FRAMEWORK_NO_GLFW
 #include <GLFW/glfw3.h>
+#endif
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <cstring>
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
@@ -13,16 +17,22 @@ static double s_prevTime = 0;
 static float s_totalTime = 0;
 static float s_deltaTime = 0;
 
+// steady_clock rather than glfwGetTime so the timer also works headless, where GLFW is never initialised
+static double ClockSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void Utilities::resetTimer()
 {
-	s_prevTime = glfwGetTime();
+	s_prevTime = ClockSeconds();
 	s_totalTime = 0;
 	s_deltaTime = 0;
 }
 
 float Utilities::tickTimer()
 {
-	double currentTime = glfwGetTime();
+	double currentTime = ClockSeconds();
 	s_deltaTime = (float)(currentTime - s_prevTime);
 	s_prevTime = currentTime;
 	return s_deltaTime;
@@ -71,13 +81,116 @@ char* Utilities::fileToBuffer(const char* a_sPath)
 	return nullptr;
 }
 
+// xxHash64 - processes the buffer in 32 byte stripes using four independent accumulators
+// so the multiply chains can overlap, then folds any remaining tail bytes into the result
+static const unsigned long long s_prime64_1 = 0x9E3779B185EBCA87ULL;
+static const unsigned long long s_prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const unsigned long long s_prime64_3 = 0x165667B19E3779F9ULL;
+static const unsigned long long s_prime64_4 = 0x85EBCA77C2B2AE63ULL;
+static const unsigned long long s_prime64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline unsigned long long rotl64(unsigned long long a_value, int a_bits)
+{
+	return (a_value << a_bits) | (a_value >> (64 - a_bits));
+}
+
+static inline unsigned long long read64(const unsigned char* a_ptr)
+{
+	unsigned long long value;
+	memcpy(&value, a_ptr, sizeof(value));
+	return value;
+}
+
+static inline unsigned int read32(const unsigned char* a_ptr)
+{
+	unsigned int value;
+	memcpy(&value, a_ptr, sizeof(value));
+	return value;
+}
+
+static inline unsigned long long hashRound(unsigned long long a_acc, unsigned long long a_input)
+{
+	a_acc += a_input * s_prime64_2;
+	a_acc = rotl64(a_acc, 31);
+	return a_acc * s_prime64_1;
+}
+
+static inline unsigned long long hashMergeRound(unsigned long long a_acc, unsigned long long a_value)
+{
+	a_acc ^= hashRound(0, a_value);
+	return a_acc * s_prime64_1 + s_prime64_4;
+}
+
+unsigned long long Utilities::hashBuffer(const void* a_data, size_t a_size, unsigned long long a_seed)
+{
+	const unsigned char* p = (const unsigned char*)a_data;
+	const unsigned char* end = p + a_size;
+	unsigned long long hash;
+
+	if (a_size >= 32)
+	{
+		const unsigned char* limit = end - 32;
+		unsigned long long v1 = a_seed + s_prime64_1 + s_prime64_2;
+		unsigned long long v2 = a_seed + s_prime64_2;
+		unsigned long long v3 = a_seed;
+		unsigned long long v4 = a_seed - s_prime64_1;
+		do
+		{
+			v1 = hashRound(v1, read64(p)); p += 8;
+			v2 = hashRound(v2, read64(p)); p += 8;
+			v3 = hashRound(v3, read64(p)); p += 8;
+			v4 = hashRound(v4, read64(p)); p += 8;
+		} while (p <= limit);
+
+		hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+		hash = hashMergeRound(hash, v1);
+		hash = hashMergeRound(hash, v2);
+		hash = hashMergeRound(hash, v3);
+		hash = hashMergeRound(hash, v4);
+	}
+	else
+	{
+		hash = a_seed + s_prime64_5;
+	}
+	hash += (unsigned long long)a_size;
+
+	// Consume the remaining 0-31 bytes
+	for (; p + 8 <= end; p += 8)
+	{
+		hash ^= hashRound(0, read64(p));
+		hash = rotl64(hash, 27) * s_prime64_1 + s_prime64_4;
+	}
+	if (p + 4 <= end)
+	{
+		hash ^= (unsigned long long)read32(p) * s_prime64_1;
+		hash = rotl64(hash, 23) * s_prime64_2 + s_prime64_3;
+		p += 4;
+	}
+	for (; p < end; ++p)
+	{
+		hash ^= (*p) * s_prime64_5;
+		hash = rotl64(hash, 11) * s_prime64_1;
+	}
+
+	// Avalanche so that every input bit affects every output bit
+	hash ^= hash >> 33;
+	hash *= s_prime64_2;
+	hash ^= hash >> 29;
+	hash *= s_prime64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
 // Utility for mouse / keyboard movement of a matrix transfrom (i.e camera)
-// Getting the current window for input handling and then splits the input argument matrix into it's vectors components.
+// Takes the window for input handling and then splits the input argument matrix into it's vectors components.
 // We will directly manipulate these individual componments within the function
-void Utilities::freeMovement(glm::mat4& a_transform, float a_deltaTime, float a_speed, const glm::vec3& a_up)
+void Utilities::freeMovement(GLFWwindow* a_window, glm::mat4& a_transform, float a_deltaTime, float a_speed, const glm::vec3& a_up)
 {
-    // Get the current window context
-    GLFWwindow* window = glfwGetCurrentContext();
+#ifdef RENDER_FRAMEWORK_NO_GLFW
+    (void)a_window; (void)a_transform; (void)a_deltaTime; (void)a_speed; (void)a_up;
+#else
+    // No window to take input from when running headless
+    if (a_window == nullptr) { return; }
     // Get the cameras forward, right, up and location vectors
     glm::vec4 vForward = a_transform[2];
     glm::vec4 vRight = a_transform[0];
@@ -85,36 +198,36 @@ void Utilities::freeMovement(glm::mat4& a_transform, float a_deltaTime, float a_
     glm::vec4 vTranslation = a_transform[3];
     // Test to see if the left shift key is pressed
     // We will use left shift to double the speed of the camera movement
-    float frameSpeed = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ? a_deltaTime * a_speed * 2 : a_deltaTime * a_speed;
+    float frameSpeed = glfwGetKey(a_window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ? a_deltaTime * a_speed * 2 : a_deltaTime * a_speed;
 
     // Checking for KEY PRESSES on the often used WASD KEYS and the QE keys to adjust the translation (Position) 
     // element of the matrix that has been passed in.
     //Translate camera 
-    if (glfwGetKey(window, 'W') == GLFW_PRESS)
+    if (glfwGetKey(a_window, 'W') == GLFW_PRESS)
     {
         vTranslation -= vForward * frameSpeed;
     }
-    if (glfwGetKey(window, 'S') == GLFW_PRESS)
+    if (glfwGetKey(a_window, 'S') == GLFW_PRESS)
     {
         vTranslation += vForward * frameSpeed;
     }
-    if (glfwGetKey(window, 'D') == GLFW_PRESS)
+    if (glfwGetKey(a_window, 'D') == GLFW_PRESS)
     {
         vTranslation += vRight * frameSpeed;
     }
-    if (glfwGetKey(window, 'A') == GLFW_PRESS)
+    if (glfwGetKey(a_window, 'A') == GLFW_PRESS)
     {
         vTranslation -= vRight * frameSpeed;
     }
-    if (glfwGetKey(window, 'Q') == GLFW_PRESS)
+    if (glfwGetKey(a_window, 'Q') == GLFW_PRESS)
     {
         vTranslation += vUp * frameSpeed;
     }
-    if (glfwGetKey(window, 'E') == GLFW_PRESS)
+    if (glfwGetKey(a_window, 'E') == GLFW_PRESS)
     {
         vTranslation -= vUp * frameSpeed;
     }
-    if (glfwGetKey(window, 'O') == GLFW_PRESS)
+    if (glfwGetKey(a_window, 'O') == GLFW_PRESS)
     {
         vTranslation = glm::vec4(10,10,10,1);
         a_transform = glm::inverse(
@@ -131,7 +244,7 @@ void Utilities::freeMovement(glm::mat4& a_transform, float a_deltaTime, float a_
     // Check for camera rotation
     // Test for mouse button being held/pressed for rotation (button 2)
     static bool sbMouseButtonDown = false;
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_2) == GLFW_PRESS)
+    if (glfwGetMouseButton(a_window, GLFW_MOUSE_BUTTON_2) == GLFW_PRESS)
     {
         static double siPrevMouseX = 0;
         static double siPrevMouseY = 0;
@@ -139,11 +252,11 @@ void Utilities::freeMovement(glm::mat4& a_transform, float a_deltaTime, float a_
         if (sbMouseButtonDown == false)
         {
             sbMouseButtonDown = true;
-            glfwGetCursorPos(window, &siPrevMouseX, &siPrevMouseY);
+            glfwGetCursorPos(a_window, &siPrevMouseX, &siPrevMouseY);
         }
 
         double mouseX = 0, mouseY = 0;
-        glfwGetCursorPos(window, &mouseX, &mouseY);
+        glfwGetCursorPos(a_window, &mouseX, &mouseY);
 
         double iDeltaX = mouseX - siPrevMouseX;
         double iDeltaY = mouseY - siPrevMouseY;
@@ -181,4 +294,5 @@ void Utilities::freeMovement(glm::mat4& a_transform, float a_deltaTime, float a_
     {
         sbMouseButtonDown = false;
     }
+#endif
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
 // GLM Includes
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
@@ -10,11 +12,82 @@
 #include "Shader.h"
 #include "ShaderUtil.h"
 #include "RenderFramework.h"
+#include "MemoryStats.h"
+#include "GpuMemory.h"
 
-int main()
+static void PrintUsage(const char* a_program)
+{
+    std::cout << "Usage: " << a_program << " [options]\n"
+        "  --headless               Render offscreen with no window (EGL surfaceless, e.g. Mesa llvmpipe)\n"
+        "  --model <path>           OBJ file to load\n"
+        "  --width <pixels>         Window or framebuffer width (default 960)\n"
+        "  --height <pixels>        Window or framebuffer height (default 540)\n"
+        "  --frames <count>         Run this many frames then print timing results\n"
+        "  --render-thread          Draw on a dedicated render thread\n"
+        "  --telemetry <path>       Write per frame telemetry, .jsonl for JSON lines otherwise CSV\n"
+        "  --trace-after <frames>   Write a CPU trace after this many frames, 0 for none\n"
+        "  --gpu-budget <MB>        Warn when GPU memory goes over this, 0 for no budget\n";
+}
+
+// Parses a whole number argument, returns false if it isn't one. 0 is only accepted where it means off
+static bool ParseCount(const char* a_text, unsigned int& a_value, bool a_allowZero = false)
+{
+    char* end = nullptr;
+    unsigned long value = strtoul(a_text, &end, 10);
+    if (end == a_text || *end != '\0' || a_text[0] == '-' || (value == 0 && !a_allowZero)) { return false; }
+    a_value = (unsigned int)value;
+    return true;
+}
+
+int main(int argc, char** argv)
 {
     RenderFramework* myApp = new RenderFramework();
-    myApp->Run("Scott Baldwin's - Render Framework", 960, 540, false);
+    unsigned int width = 960;
+    unsigned int height = 540;
+#ifdef RENDER_FRAMEWORK_NO_GLFW
+    // Built without GLFW there's no window to open
+    bool headless = true;
+#else
+    bool headless = false;
+#endif
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        unsigned int count = 0;
+        if (strcmp(arg, "--headless") == 0) { headless = true; }
+        else if (strcmp(arg, "--render-thread") == 0) { myApp->SetRenderThread(true); }
+        else if (strcmp(arg, "--model") == 0 && value != nullptr) { myApp->SetModelPath(value); ++i; }
+        else if (strcmp(arg, "--width") == 0 && value != nullptr && ParseCount(value, width)) { ++i; }
+        else if (strcmp(arg, "--height") == 0 && value != nullptr && ParseCount(value, height)) { ++i; }
+        else if (strcmp(arg, "--frames") == 0 && value != nullptr && ParseCount(value, count)) { myApp->SetFrameLimit(count); ++i; }
+        else if (strcmp(arg, "--trace-after") == 0 && value != nullptr && ParseCount(value, count, true)) { myApp->SetTraceAfterFrames(count); ++i; }
+        else if (strcmp(arg, "--gpu-budget") == 0 && value != nullptr && ParseCount(value, count, true)) { GpuMemory::SetBudget((size_t)count * 1024 * 1024); ++i; }
+        else if (strcmp(arg, "--telemetry") == 0 && value != nullptr)
+        {
+            TelemetryConfig config;
+            config.path = value;
+            size_t length = config.path.size();
+            if (length > 6 && config.path.compare(length - 6, 6, ".jsonl") == 0) { config.format = TelemetryConfig::JsonLines; }
+            myApp->EnableTelemetry(config);
+            ++i;
+        }
+        else
+        {
+            std::cout << "Unknown or incomplete option: " << arg << std::endl;
+            PrintUsage(argv[0]);
+            delete myApp;
+            return 1;
+        }
+    }
+    myApp->SetHeadless(headless);
+    // A headless run with no frame count would never end
+    if (headless)
+    {
+        myApp->SetFrameLimit(myApp->GetFrameLimit() > 0 ? myApp->GetFrameLimit() : 300);
+    }
+    bool ran = myApp->Run("Scott Baldwin's - Render Framework", width, height, false);
     delete myApp;
-    return 0;
+    MemoryStats::ReportLeaks();
+    return ran ? 0 : 1;
 }
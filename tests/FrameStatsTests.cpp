@@ -0,0 +1,89 @@
+// FrameTimeSeries tests, run with ctest. Everything is checked against a plain sorted copy of the window
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+static bool Check(bool a_condition, const char* a_test, const char* a_what)
+{
+	if (!a_condition)
+	{
+		printf("FAILED %s: %s\n", a_test, a_what);
+	}
+	return a_condition;
+}
+
+// What GetPercentile should report, the top of the bucket the ranked sample lands in capped at the max
+static float ReferencePercentile(const std::vector<float>& a_sorted, float a_percentile)
+{
+	unsigned int count = (unsigned int)a_sorted.size();
+	unsigned int rank = (unsigned int)(a_percentile / 100.f * count + 0.5f);
+	if (rank < 1) { rank = 1; }
+	if (rank > count) { rank = count; }
+	float maximum = a_sorted.back();
+	unsigned int bucket = (unsigned int)(a_sorted[rank - 1] / FrameTimeSeries::BucketWidthMs);
+	if (bucket >= FrameTimeSeries::BucketCount - 1) { return maximum; }
+	float top = (bucket + 1) * FrameTimeSeries::BucketWidthMs;
+	return (top < maximum) ? top : maximum;
+}
+
+// Fills well past Capacity with a mix of normal frames, hitches and a few past the histogram's last bucket, with the
+// slowest frame of the run early on so it gets evicted. Every step is compared against the reference window
+static bool RollingWindowMatchesReference()
+{
+	FrameTimeSeries series;
+	const float threshold = 33.3f;
+	series.SetHitchThreshold(threshold);
+	std::deque<float> window;
+	unsigned long long totalHitches = 0;
+	unsigned int random = 12345;
+	bool ok = true;
+	const unsigned int sampleCount = FrameTimeSeries::Capacity * 3 + 17;
+	for (unsigned int i = 0; i < sampleCount && ok; ++i)
+	{
+		random = random * 1664525u + 1013904223u;
+		float ms = 4.f + (float)(random >> 8 & 0xFFFF) / 65535.f * 20.f;
+		if (i == 10) { ms = 500.f; }
+		else if (random % 53 == 0) { ms = 40.f + (float)(random % 90); }
+		else if (random % 211 == 0) { ms = 120.f + (float)(random % 200); }
+
+		series.AddSample(ms);
+		window.push_back(ms);
+		if (window.size() > FrameTimeSeries::Capacity) { window.pop_front(); }
+		if (ms > threshold) { ++totalHitches; }
+
+		std::vector<float> sorted(window.begin(), window.end());
+		std::sort(sorted.begin(), sorted.end());
+		unsigned int windowHitches = (unsigned int)std::count_if(sorted.begin(), sorted.end(), [threshold](float a_ms) { return a_ms > threshold; });
+		ok = Check(series.GetCount() == sorted.size(), "RollingWindowMatchesReference", "count is wrong");
+		ok = ok && Check(series.GetMax() == sorted.back(), "RollingWindowMatchesReference", "max is wrong");
+		ok = ok && Check(series.GetHitchCount() == windowHitches, "RollingWindowMatchesReference", "window hitch count is wrong");
+		ok = ok && Check(series.GetTotalHitches() == totalHitches, "RollingWindowMatchesReference", "total hitch count is wrong");
+		ok = ok && Check(series.GetPercentile(50.f) == ReferencePercentile(sorted, 50.f), "RollingWindowMatchesReference", "p50 is wrong");
+		ok = ok && Check(series.GetPercentile(99.f) == ReferencePercentile(sorted, 99.f), "RollingWindowMatchesReference", "p99 is wrong");
+		if (!ok) { printf("  at sample %u\n", i); }
+	}
+	// The 500ms frame has long gone, the max must have moved on from it
+	return ok && Check(series.GetMax() < 500.f, "RollingWindowMatchesReference", "evicted max is still reported");
+}
+
+// A window of equal samples evicts the front of the max queue one at a time
+static bool EqualSamplesKeepMax()
+{
+	FrameTimeSeries series;
+	for (unsigned int i = 0; i < FrameTimeSeries::Capacity * 2; ++i) { series.AddSample(16.f); }
+	bool ok = Check(series.GetMax() == 16.f && series.GetCount() == FrameTimeSeries::Capacity, "EqualSamplesKeepMax", "max lost");
+	series.AddSample(8.f);
+	return ok && Check(series.GetMax() == 16.f && series.GetLatest() == 8.f, "EqualSamplesKeepMax", "max lost after a smaller sample");
+}
+
+int main()
+{
+	bool ok = true;
+	ok = RollingWindowMatchesReference() && ok;
+	ok = EqualSamplesKeepMax() && ok;
+	printf(ok ? "All frame stats tests passed\n" : "Frame stats tests failed\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+// Job system tests, run with ctest. Each test returns false on failure, a hang is caught by the ctest timeout
+#include "JobSystem.h"
+
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
+static bool Check(bool a_condition, const char* a_test, const char* a_what)
+{
+	if (!a_condition)
+	{
+		printf("FAILED %s: %s\n", a_test, a_what);
+	}
+	return a_condition;
+}
+
+// With no background workers everything runs on this thread inside Wait, a job whose dependency isn't done must not
+// stop the job it depends on from being reached
+static bool DependencyChainWithoutWorkers()
+{
+	JobSystem jobSystem(0);
+	std::vector<int> order;
+	std::vector<int>* orderPtr = &order;
+	JobCounter a, b, c;
+	jobSystem.Run([orderPtr]() { orderPtr->push_back(1); }, &a);
+	jobSystem.Run([orderPtr]() { orderPtr->push_back(2); }, &b, &a);
+	jobSystem.Run([orderPtr]() { orderPtr->push_back(3); }, &c, &b);
+	jobSystem.Wait(&c);
+	bool ok = Check(order.size() == 3, "DependencyChainWithoutWorkers", "not every job ran");
+	ok = ok && Check(order[0] == 1 && order[1] == 2 && order[2] == 3, "DependencyChainWithoutWorkers", "jobs ran out of order");
+	return ok && Check(a.IsDone() && b.IsDone(), "DependencyChainWithoutWorkers", "counters not done");
+}
+
+// Queue more jobs than the ring holds while the first one can't run yet, its slot must not be handed out again
+static bool RingWrapsPastQueuedJob()
+{
+	JobSystem jobSystem(0);
+	std::atomic<int> ran(0);
+	std::atomic<int>* ranPtr = &ran;
+	JobCounter gate, dependents;
+	jobSystem.Run([ranPtr]() { ranPtr->fetch_add(1000000); }, &gate);
+	const int jobCount = 3 * 4096;
+	for (int i = 0; i < jobCount; ++i)
+	{
+		jobSystem.Run([ranPtr]() { ranPtr->fetch_add(1); }, &dependents, &gate);
+	}
+	jobSystem.Wait(&dependents);
+	return Check(ran.load() == 1000000 + jobCount, "RingWrapsPastQueuedJob", "a job was lost or ran twice");
+}
+
+// Chains and parallel loops on background workers
+static bool DependencyChainWithWorkers()
+{
+	JobSystem jobSystem(3);
+	bool ok = true;
+	for (int run = 0; run < 200 && ok; ++run)
+	{
+		std::atomic<int> step(0);
+		std::atomic<int>* stepPtr = &step;
+		std::atomic<bool> inOrder(true);
+		std::atomic<bool>* inOrderPtr = &inOrder;
+		JobCounter counters[8];
+		for (int i = 0; i < 8; ++i)
+		{
+			jobSystem.Run([stepPtr, inOrderPtr, i]()
+			{
+				if (stepPtr->fetch_add(1) != i) { inOrderPtr->store(false); }
+			}, &counters[i], i > 0 ? &counters[i - 1] : nullptr);
+		}
+		jobSystem.Wait(&counters[7]);
+		ok = Check(step.load() == 8 && inOrder.load(), "DependencyChainWithWorkers", "chain ran out of order");
+
+		std::atomic<long long> sum(0);
+		jobSystem.ParallelFor(10000, [&sum](size_t a_begin, size_t a_end)
+		{
+			long long local = 0;
+			for (size_t i = a_begin; i < a_end; ++i) { local += (long long)i; }
+			sum.fetch_add(local);
+		});
+		ok = ok && Check(sum.load() == 10000LL * 9999 / 2, "DependencyChainWithWorkers", "ParallelFor sum is wrong");
+	}
+	return ok;
+}
+
+int main()
+{
+	bool ok = true;
+	ok = DependencyChainWithoutWorkers() && ok;
+	ok = RingWrapsPastQueuedJob() && ok;
+	ok = DependencyChainWithWorkers() && ok;
+	printf(ok ? "All job system tests passed\n" : "Job system tests failed\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// SlotMap tests, run with ctest. Stale handles are only checked with Contains, Get and Remove on one asserts in debug builds
+#include "SlotMap.h"
+
+#include <cstdio>
+#include <string>
+
+struct TestTag {};
+typedef SlotMap<std::string, TestTag> TestMap;
+
+static bool Check(bool a_condition, const char* a_test, const char* a_what)
+{
+	if (!a_condition)
+	{
+		printf("FAILED %s: %s\n", a_test, a_what);
+	}
+	return a_condition;
+}
+
+// Removing a value bumps its slot's generation, so the old handle goes stale even once the slot is reused
+static bool RemoveBumpsGeneration()
+{
+	TestMap map;
+	TestMap::HandleType handle = map.Insert("first");
+	bool ok = Check(handle.IsValid() && map.Contains(handle), "RemoveBumpsGeneration", "new handle isn't valid");
+	ok = ok && Check(map.Remove(handle), "RemoveBumpsGeneration", "remove failed");
+	ok = ok && Check(!map.Contains(handle) && map.Empty(), "RemoveBumpsGeneration", "removed handle still resolves");
+	TestMap::HandleType reused = map.Insert("second");
+	ok = ok && Check(reused.index == handle.index, "RemoveBumpsGeneration", "slot wasn't reused");
+	ok = ok && Check(reused.generation == handle.generation + 1, "RemoveBumpsGeneration", "generation wasn't bumped");
+	ok = ok && Check(!map.Contains(handle) && *map.Get(reused) == "second", "RemoveBumpsGeneration", "old handle resolves to the new value");
+	return ok && Check(!map.Contains(TestMap::HandleType()), "RemoveBumpsGeneration", "default handle resolves");
+}
+
+// Freed slots are reused most recently freed first, before the slot array grows
+static bool FreeListReuse()
+{
+	TestMap map;
+	TestMap::HandleType handles[4];
+	for (int i = 0; i < 4; ++i) { handles[i] = map.Insert(std::to_string(i)); }
+	map.Remove(handles[1]);
+	map.Remove(handles[3]);
+	TestMap::HandleType a = map.Insert("a");
+	TestMap::HandleType b = map.Insert("b");
+	TestMap::HandleType c = map.Insert("c");
+	bool ok = Check(a.index == handles[3].index && b.index == handles[1].index, "FreeListReuse", "free slots not reused in order");
+	ok = ok && Check(c.index == 4, "FreeListReuse", "new slot not appended once the free list was empty");
+	map.Clear();
+	TestMap::HandleType d = map.Insert("d");
+	ok = ok && Check(map.Size() == 1 && !map.Contains(a) && !map.Contains(c), "FreeListReuse", "Clear left handles valid");
+	return ok && Check(d.index < 5 && *map.Get(d) == "d", "FreeListReuse", "Clear didn't free its slots");
+}
+
+// Removing from the middle moves the last value into the hole, its handle has to follow it
+static bool SwapRemoveFixesMovedHandle()
+{
+	TestMap map;
+	TestMap::HandleType first = map.Insert("first");
+	TestMap::HandleType middle = map.Insert("middle");
+	TestMap::HandleType last = map.Insert("last");
+	map.Remove(first);
+	bool ok = Check(map.Size() == 2, "SwapRemoveFixesMovedHandle", "size is wrong");
+	ok = ok && Check(map.Contains(last) && *map.Get(last) == "last", "SwapRemoveFixesMovedHandle", "moved value lost its handle");
+	ok = ok && Check(*map.Get(middle) == "middle", "SwapRemoveFixesMovedHandle", "untouched value changed");
+	ok = ok && Check(*map.begin() == "last" && map.GetHandleAt(0) == last, "SwapRemoveFixesMovedHandle", "last value wasn't moved into the hole");
+	map.Remove(last);
+	ok = ok && Check(map.Size() == 1 && *map.Get(middle) == "middle" && map.GetHandleAt(0) == middle, "SwapRemoveFixesMovedHandle",
+		"second remove broke the remaining handle");
+	return ok;
+}
+
+int main()
+{
+	bool ok = true;
+	ok = RemoveBumpsGeneration() && ok;
+	ok = FreeListReuse() && ok;
+	ok = SwapRemoveFixesMovedHandle() && ok;
+	printf(ok ? "All slot map tests passed\n" : "Slot map tests failed\n");
+	return ok ? 0 : 1;
+}